@@ -9,7 +9,13 @@ void CAN_task_runnable( void *)
   while( true)
     {
       notify_take();
-      CAN_output( output_data);
+      uint32_t sequence;
+      do // torn data set: send again, receivers keep the latest values
+	{
+	  sequence = output_data_lock.read_begin();
+	  CAN_output( output_data);
+	}
+      while( output_data_lock.read_retry( sequence));
     }
 }
 
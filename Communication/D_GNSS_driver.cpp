@@ -10,8 +10,14 @@
 #include "stm32f4xx_hal.h"
 #include "GNSS.h"
 #include "D_GNSS_driver.h"
+#include "GNSS_driver.h"
+#include "UBX_parser.h"
 #include "system_state.h"
 
+#define DATA_PACKET_TIMEOUT_MS 250
+#define RECONFIGURATION_TIMEOUT_MS 2000 // no frame for this time: receiver has been power-cycled
+#define RX_RING_SIZE 512 // circular DMA buffer, > 2 * RELPOSNED frame @ 20 Hz
+
 COMMON UART_HandleTypeDef huart4;
 COMMON DMA_HandleTypeDef hdma_uart4_rx;
 COMMON  static TaskHandle_t USART4_task_Id = NULL;
@@ -43,7 +49,7 @@ static inline void MX_USART4_UART_Init (void)
     hdma_uart4_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_uart4_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_uart4_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_uart4_rx.Init.Mode = DMA_NORMAL;
+    hdma_uart4_rx.Init.Mode = DMA_CIRCULAR;
     hdma_uart4_rx.Init.Priority = DMA_PRIORITY_HIGH;
     hdma_uart4_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
     if (HAL_DMA_Init(&hdma_uart4_rx) != HAL_OK)
@@ -52,7 +58,7 @@ static inline void MX_USART4_UART_Init (void)
     __HAL_LINKDMA( &huart4, hdmarx, hdma_uart4_rx);
 
     huart4.Instance = UART4;
-    huart4.Init.BaudRate = 115200;
+    huart4.Init.BaudRate = GNSS_DEFAULT_BAUDRATE;
     huart4.Init.WordLength = UART_WORDLENGTH_8B;
     huart4.Init.StopBits = UART_STOPBITS_1;
     huart4.Init.Parity = UART_PARITY_NONE;
@@ -64,6 +70,11 @@ static inline void MX_USART4_UART_Init (void)
 
     HAL_NVIC_SetPriority (DMA1_Stream2_IRQn, STANDARD_ISR_PRIORITY, 0);
     HAL_NVIC_EnableIRQ (DMA1_Stream2_IRQn);
+
+    // idle line: end of a frame
+    __HAL_UART_ENABLE_IT( &huart4, UART_IT_IDLE);
+    HAL_NVIC_SetPriority (UART4_IRQn, STANDARD_ISR_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ (UART4_IRQn);
 }
 
 /**
@@ -78,46 +89,68 @@ DMA1_Stream2_IRQHandler (void)
   portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
 }
 
-#define DGNSS_DMA_buffer_SIZE (sizeof( uBlox_relpos_NED) + 8) // plus "u B class id size1 size2 ... cks1 cks2"
+/**
+ * @brief UART4 interrupt: idle line and receive errors
+ */
+extern "C" void
+UART4_IRQHandler (void)
+{
+  __HAL_UART_CLEAR_PEFLAG( &huart4); // clears IDLE, ORE, NE, FE and PE
+
+  BaseType_t HigherPriorityTaskWoken=0;
+  vTaskNotifyGiveFromISR( USART4_task_Id, &HigherPriorityTaskWoken);
+  portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
+}
 
-static uint8_t buffer[DGNSS_DMA_buffer_SIZE];
+static uint8_t __ALIGNED(RX_RING_SIZE) rx_ring[RX_RING_SIZE];
+static UBX_parser parser;
 
 void USART_4_runnable(void*)
 {
   USART4_task_Id = xTaskGetCurrentTaskHandle();
   MX_USART4_UART_Init ();
-  volatile HAL_StatusTypeDef result;
+  configure_GNSS_receiver( huart4, UBX_RELPOSNED);
+
+  unsigned tail = 0;
+  uint32_t frames = 0;
+  TickType_t last_frame_time = xTaskGetTickCount();
   while (true)
     {
-      result = HAL_UART_Receive_DMA (&huart4, buffer, DGNSS_DMA_buffer_SIZE);
-      if( result != HAL_OK)
+      if( huart4.RxState != HAL_UART_STATE_BUSY_RX) // initially or after DMA error
 	{
 	  HAL_UART_Abort (&huart4);
-	  continue;
+	  if( HAL_UART_Receive_DMA (&huart4, rx_ring, RX_RING_SIZE) != HAL_OK)
+	    {
+	      delay( 10);
+	      continue;
+	    }
+	  tail = 0;
 	}
+
       uint32_t pulNotificationValue;
-      BaseType_t notify_result = xTaskNotifyWait( 0xffffffff, 0xffffffff, &pulNotificationValue, 100);
-      if( notify_result != pdTRUE)
+      xTaskNotifyWait( 0xffffffff, 0xffffffff, &pulNotificationValue, DATA_PACKET_TIMEOUT_MS);
+
+      unsigned head = (RX_RING_SIZE - __HAL_DMA_GET_COUNTER( &hdma_uart4_rx)) % RX_RING_SIZE;
+      while( tail != head)
 	{
-	  HAL_UART_Abort (&huart4);
-	  continue;
+	  bool complete = parser.feed( rx_ring[tail]);
+	  tail = (tail + 1) % RX_RING_SIZE;
+	  if( complete)
+	    GNSS.dispatch( parser.get_frame());
 	}
-      notify_result = xTaskNotifyWait( 0xffffffff, 0xffffffff, &pulNotificationValue, 10);
-      if( notify_result != pdTRUE)
+
+      if( parser.frames != frames)
+	{
+	  frames = parser.frames;
+	  last_frame_time = xTaskGetTickCount();
+	}
+      else if( xTaskGetTickCount() - last_frame_time > RECONFIGURATION_TIMEOUT_MS)
 	{
 	  HAL_UART_Abort (&huart4);
-	  continue;
+	  configure_GNSS_receiver( huart4, UBX_RELPOSNED);
+	  last_frame_time = xTaskGetTickCount();
 	}
-      HAL_UART_Abort (&huart4);
-
-      GNSS_Result result = GNSS.update_delta(buffer);
-
-      if(  result == GNSS_HAVE_FIX)
-	update_system_state_set( D_GNSS_AVAILABLE);
-
-      delay( 150); // uBlox sends every 200ms for 3ms
     }
 }
 
 // Task usart4_task (USART_4_runnable, "D-GNSS", 256, 0, STANDARD_TASK_PRIORITY+1);
-
@@ -9,15 +9,55 @@
 #include "stm32f4xx_hal.h"
 #include "GNSS.h"
 #include "GNSS_driver.h"
+#include "UBX_parser.h"
+#include "GNSS_time_alignment.h"
+
+uint64_t getTime_usec(void);
+
+#define CONFIGURATION_TX_TIMEOUT_MS 50
+#define BAUDRATE_SWITCH_DELAY_MS 20
+
+static void set_baudrate( UART_HandleTypeDef & huart, uint32_t baudrate)
+{
+  huart.Init.BaudRate = baudrate;
+  if (HAL_UART_Init(&huart) != HAL_OK)
+    ASSERT(0);
+}
+
+void configure_GNSS_receiver( UART_HandleTypeDef & huart, UBX_receiver_role_t role)
+{
+#if GNSS_CONFIGURE_RECEIVER
+  uint8_t frame[UBX_CONFIGURATION_MAX_FRAME];
+  unsigned size = make_UBX_configuration( frame, role, GNSS_BAUDRATE);
+
+  // after a power-up the receiver runs from flash,
+  // after a CPU reset it may still run the configuration from RAM
+  const uint32_t baudrates[] = { GNSS_DEFAULT_BAUDRATE, GNSS_BAUDRATE};
+  for( uint32_t baudrate : baudrates)
+    {
+      set_baudrate( huart, baudrate);
+      HAL_UART_Transmit( &huart, frame, size, CONFIGURATION_TX_TIMEOUT_MS);
+      delay( BAUDRATE_SWITCH_DELAY_MS);
+    }
+#else
+  set_baudrate( huart, GNSS_DEFAULT_BAUDRATE);
+#endif
+}
 
 #if RUN_GNSS
 
 #define DATA_PACKET_TIMEOUT_MS 250 //
+#define RECONFIGURATION_TIMEOUT_MS 2000 // no frame for this time: receiver has been power-cycled
+#define RX_RING_SIZE 1024 // circular DMA buffer, > 2 * (PVT + RELPOSNED frame) @ 20 Hz
 
 COMMON UART_HandleTypeDef huart3;
 COMMON DMA_HandleTypeDef hdma_usart3_rx;
 COMMON  static TaskHandle_t USART3_task_Id = NULL;
 
+// end of the latest burst of frames
+COMMON static volatile uint64_t idle_time_usec;
+COMMON static volatile unsigned idle_position;
+
 /**
  * @brief USART3 Initialization Function
  */
@@ -45,7 +85,7 @@ static inline void MX_USART3_UART_Init (void)
     hdma_usart3_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart3_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart3_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart3_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart3_rx.Init.Mode = DMA_CIRCULAR;
     hdma_usart3_rx.Init.Priority = DMA_PRIORITY_MEDIUM;
     hdma_usart3_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
     if (HAL_DMA_Init(&hdma_usart3_rx) != HAL_OK)
@@ -54,7 +94,7 @@ static inline void MX_USART3_UART_Init (void)
     __HAL_LINKDMA( &huart3, hdmarx, hdma_usart3_rx);
 
     huart3.Instance = USART3;
-    huart3.Init.BaudRate = 115200;
+    huart3.Init.BaudRate = GNSS_DEFAULT_BAUDRATE;
     huart3.Init.WordLength = UART_WORDLENGTH_8B;
     huart3.Init.StopBits = UART_STOPBITS_1;
     huart3.Init.Parity = UART_PARITY_NONE;
@@ -66,6 +106,11 @@ static inline void MX_USART3_UART_Init (void)
 
     HAL_NVIC_SetPriority (DMA1_Stream1_IRQn, STANDARD_ISR_PRIORITY, 0);
     HAL_NVIC_EnableIRQ (DMA1_Stream1_IRQn);
+
+    // idle line: end of a burst of frames
+    __HAL_UART_ENABLE_IT( &huart3, UART_IT_IDLE);
+    HAL_NVIC_SetPriority (USART3_IRQn, STANDARD_ISR_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ (USART3_IRQn);
 }
 
 /**
@@ -80,64 +125,97 @@ DMA1_Stream1_IRQHandler (void)
   portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
 }
 
-#define GPS_DMA_buffer_SIZE (sizeof( uBlox_pvt) + 8) // plus "u B class id size1 size2 ... cks1 cks2"
+/**
+ * @brief USART3 interrupt: idle line and receive errors
+ */
+extern "C" void
+USART3_IRQHandler (void)
+{
+  if( __HAL_UART_GET_FLAG( &huart3, UART_FLAG_IDLE))
+    {
+      idle_time_usec = getTime_usec_privileged();
+      idle_position = (RX_RING_SIZE - __HAL_DMA_GET_COUNTER( &hdma_usart3_rx)) % RX_RING_SIZE;
+    }
 
-#define GPS_RELPOS_DMA_buffer_SIZE (sizeof( uBlox_relpos_NED) + 8) // plus "u B class id size1 size2 ... cks1 cks2"
-#define RECEIVE_BUFFER_SIZE (GPS_DMA_buffer_SIZE+GPS_RELPOS_DMA_buffer_SIZE)
+  // IDLE, ORE, NE, FE and PE are all cleared reading SR then DR,
+  // a byte lost by an overrun will be handled by the frame parser
+  __HAL_UART_CLEAR_PEFLAG( &huart3);
+
+  BaseType_t HigherPriorityTaskWoken=0;
+  vTaskNotifyGiveFromISR( USART3_task_Id, &HigherPriorityTaskWoken);
+  portEND_SWITCHING_ISR(HigherPriorityTaskWoken);
+}
 
-static uint8_t __ALIGNED(256) buffer[RECEIVE_BUFFER_SIZE];
+static uint8_t __ALIGNED(RX_RING_SIZE) rx_ring[RX_RING_SIZE];
+static UBX_parser parser;
+static GNSS_time_alignment time_alignment( GNSS_OUTPUT_LATENCY_USEC);
 
 void
 USART_3_runnable (void *using_DGNSS)
 {
-  unsigned buffer_size =
-      *(bool*) using_DGNSS ?
-	  GPS_DMA_buffer_SIZE + GPS_RELPOS_DMA_buffer_SIZE :
-	  GPS_DMA_buffer_SIZE;
+  // F9P + F9P: RELPOSNED on this port as well
+  UBX_receiver_role_t role = *(bool*) using_DGNSS ? UBX_PVT_RELPOSNED : UBX_PVT;
+  // last message of an epoch, then the solution is complete
+  uint8_t epoch_end = role == UBX_PVT_RELPOSNED ? UBX_NAV_RELPOSNED : UBX_NAV_PVT;
 
   USART3_task_Id = xTaskGetCurrentTaskHandle ();
   MX_USART3_UART_Init ();
-  volatile HAL_StatusTypeDef result;
+  configure_GNSS_receiver (huart3, role);
 
+  unsigned tail = 0;
+  uint32_t frames = 0;
+  TickType_t last_frame_time = xTaskGetTickCount ();
   while (true)
     {
-      result = HAL_UART_Receive_DMA (&huart3, buffer, buffer_size);
-      if (result != HAL_OK)
+      if (huart3.RxState != HAL_UART_STATE_BUSY_RX) // initially or after DMA error
 	{
 	  HAL_UART_Abort (&huart3);
-	  continue;
+	  if (HAL_UART_Receive_DMA (&huart3, rx_ring, RX_RING_SIZE) != HAL_OK)
+	    {
+	      delay (10);
+	      continue;
+	    }
+	  tail = idle_position = 0;
 	}
-      // wait for half transfer interrupt
+
+      // woken by idle line, half transfer or transfer complete
       uint32_t pulNotificationValue;
-      BaseType_t notify_result = xTaskNotifyWait(0xffffffff, 0xffffffff,
-						 &pulNotificationValue,
-						 DATA_PACKET_TIMEOUT_MS);
-      if (notify_result != pdTRUE)
+      xTaskNotifyWait(0xffffffff, 0xffffffff, &pulNotificationValue, DATA_PACKET_TIMEOUT_MS);
+
+      // parse up to the end of the latest burst only:
+      // an epoch's last frame is then followed by the idle line time stamp
+      taskENTER_CRITICAL();
+      unsigned head = idle_position;
+      uint64_t capture_time_usec = idle_time_usec;
+      taskEXIT_CRITICAL();
+
+      unsigned live_head = (RX_RING_SIZE - __HAL_DMA_GET_COUNTER( &hdma_usart3_rx)) % RX_RING_SIZE;
+      if ((live_head - tail) % RX_RING_SIZE > RX_RING_SIZE / 2) // no idle line for long: avoid overrun
 	{
-	  HAL_UART_Abort (&huart3);
-	  continue;
+	  head = live_head;
+	  capture_time_usec = getTime_usec ();
 	}
-      // wait for transfer complete interrupt
-      notify_result = xTaskNotifyWait(0xffffffff, 0xffffffff,
-				      &pulNotificationValue,
-				      DATA_PACKET_TIMEOUT_MS);
-      if (notify_result != pdTRUE)
+
+      while (tail != head)
 	{
-	  HAL_UART_Abort (&huart3);
-	  continue;
+	  bool complete = parser.feed (rx_ring[tail]);
+	  tail = (tail + 1) % RX_RING_SIZE;
+	  if (complete && (GNSS.dispatch (parser.get_frame ()) != GNSS_ERROR)
+	      && (parser.get_id () == epoch_end))
+	    GNSS.publish (capture_time_usec,
+			  time_alignment.update (capture_time_usec, GNSS.get_iTOW_ms ()));
 	}
-      HAL_UART_Abort (&huart3);
-
-      GNSS_Result result;
-      if (buffer_size == GPS_DMA_buffer_SIZE + GPS_RELPOS_DMA_buffer_SIZE)
-	result = GNSS.update_combined (buffer);
-      else
-	result = GNSS.update (buffer);
 
-      if (result == GNSS_ERROR)
+      if (parser.frames != frames)
+	{
+	  frames = parser.frames;
+	  last_frame_time = xTaskGetTickCount ();
+	}
+      else if (xTaskGetTickCount () - last_frame_time > RECONFIGURATION_TIMEOUT_MS)
 	{
 	  HAL_UART_Abort (&huart3);
-	  delay (50);
+	  configure_GNSS_receiver (huart3, role);
+	  last_frame_time = xTaskGetTickCount ();
 	}
     }
 }
@@ -3,4 +3,10 @@
  @brief GNSS USART driver
  @author: Dr. Klaus Schaefer
  */
+#include "stm32f4xx_hal.h"
+#include "UBX_configuration.h"
+
 void USART_3_runnable (void* using_DGNSS);
+
+//! configure the receiver and leave the UART at GNSS_BAUDRATE
+void configure_GNSS_receiver( UART_HandleTypeDef & huart, UBX_receiver_role_t role);
@@ -19,22 +19,136 @@
 #include "GNSS_driver.h"
 #include "CAN_distributor.h"
 #include "system_state.h"
+#include "data_logger.h"
+#include "stage_timing.h"
+#include "adc_sense.h"
+#include "IMU_decimator.h"
+#include "math.h"
+
+uint64_t getTime_usec(void);
+
+#define GNSS_MAX_EXTRAPOLATION_USEC 200000 // older epochs are applied as they are
+#define IMU_DELAY_USEC IMU_decimator::group_delay_usec( IMU_OVERSAMPLING) // IMU sample time before its arrival
 
-extern "C" void sync_logger (void);
 
 COMMON Semaphore SD_card_to_communicator_synchronizer(1,0,"SD2COM");
 COMMON bool replaying_data=false;
 COMMON Semaphore new_data_read;
 
 COMMON output_data_t __ALIGNED(1024) output_data = { 0 };
-COMMON GNSS_type GNSS (output_data.c);
+COMMON seqlock_t output_data_lock;
+COMMON seqlocked<imu_sample_t> imu_slot;
+COMMON seqlocked<pressure_sample_t> pressure_slot;
+COMMON seqlocked<float> pitot_slot;
+COMMON seqlocked<lowcost_acc_mag_sample_t> lowcost_acc_mag_slot;
+COMMON seqlocked<lowcost_gyro_sample_t> lowcost_gyro_slot;
+COMMON coordinates_t GNSS_coordinates; //!< GNSS tasks' working copy, see GNSS_solutions
+COMMON GNSS_type GNSS (GNSS_coordinates);
 COMMON Queue < observations_type> input(2);
 
 extern RestrictedTask NMEA_task;
+#if RUN_MS5611_MODULE || RUN_PITOT_MODULE || RUN_FXOS8700
+extern RestrictedTask i2c_sensors;
+#endif
 
 static ROM bool TRUE=true;
 static ROM bool FALSE=false;
 
+//! take over the latest sensor samples, keep the previous ones if a sensor task is just writing
+static void latch_sensor_data( measurement_data_t & m)
+{
+  imu_sample_t imu;
+  if( imu_slot.try_read( imu))
+    for( unsigned i = 0; i < 3; ++i)
+      {
+	m.acc[i]  = imu.acc[i];
+	m.gyro[i] = imu.gyro[i];
+	m.mag[i]  = imu.mag[i];
+      }
+
+  pressure_sample_t pressure;
+  if( pressure_slot.try_read( pressure))
+    {
+      m.static_pressure = pressure.static_pressure;
+      m.static_sensor_temperature = pressure.static_sensor_temperature;
+      m.absolute_pressure = pressure.absolute_pressure;
+      m.absolute_sensor_temperature = pressure.absolute_sensor_temperature;
+    }
+
+  float pitot_pressure;
+  if( pitot_slot.try_read( pitot_pressure))
+    m.pitot_pressure = pitot_pressure;
+
+  lowcost_acc_mag_sample_t lowcost_acc_mag;
+  if( lowcost_acc_mag_slot.try_read( lowcost_acc_mag))
+    for( unsigned i = 0; i < 3; ++i)
+      {
+	m.lowcost_acc[i] = lowcost_acc_mag.acc[i];
+	m.lowcost_mag[i] = lowcost_acc_mag.mag[i];
+      }
+
+  lowcost_gyro_sample_t lowcost_gyro;
+  if( lowcost_gyro_slot.try_read( lowcost_gyro))
+    for( unsigned i = 0; i < 3; ++i)
+      m.lowcost_gyro[i] = lowcost_gyro.gyro[i];
+
+  m.supply_voltage = ADC_get_supply_voltage();
+}
+
+#if GNSS_LATENCY_COMPENSATION
+//! GNSS epoch at the IMU sample time for the organizer, output_data.c keeps the measurement as it is
+static coordinates_t GNSS_at_IMU_time;
+
+//! shift the position of a GNSS epoch from its measurement time to the IMU sample time, velocity as measured
+static coordinates_t & extrapolate_GNSS_position( const GNSS_solution_t & solution, uint64_t IMU_time_usec)
+{
+  GNSS_at_IMU_time = solution.coordinates;
+
+  // negative: epoch measured after the (filter delayed) IMU sample, shift it back
+  int64_t age_usec = (int64_t)( IMU_time_usec - solution.measurement_time_usec);
+  if( (age_usec < -GNSS_MAX_EXTRAPOLATION_USEC) || (age_usec > GNSS_MAX_EXTRAPOLATION_USEC))
+    return GNSS_at_IMU_time;
+
+  coordinates_t & c = GNSS_at_IMU_time;
+  if( isnan( c.velocity[NORTH])) // no fix
+    return GNSS_at_IMU_time;
+
+  float age = (float)age_usec * 1e-6f;
+  for( unsigned i = 0; i < 3; ++i)
+    c.position[i] += c.velocity[i] * age;
+  return GNSS_at_IMU_time;
+}
+#endif
+
+//! apply all GNSS epochs received since the last cycle in order, @return true if there has been any
+static bool consume_GNSS_solutions( organizer_t & organizer)
+{
+  GNSS_solution_t solution;
+  bool consumed = false;
+  while( GNSS_solutions.pop( solution))
+    {
+      output_data.c = solution.coordinates;
+#if GNSS_LATENCY_COMPENSATION
+      organizer.update_GNSS_data( extrapolate_GNSS_position( solution, getTime_usec() - IMU_DELAY_USEC));
+#else
+      organizer.update_GNSS_data( output_data.c);
+#endif
+      consumed = true;
+    }
+  return consumed;
+}
+
+//! block until the first GNSS epoch is available and apply it
+static void wait_for_GNSS_solution( organizer_t & organizer)
+{
+  while( GNSS_solutions.is_empty())
+    delay( 10);
+
+  output_data_lock.write_begin();
+  consume_GNSS_solutions( organizer);
+  output_data_lock.write_end();
+}
+
 void communicator_runnable (void*)
 {
   organizer_t organizer;
@@ -56,8 +170,9 @@ void communicator_runnable (void*)
       ASSERT(result);
     }
 
-  GNSS_configration_t GNSS_configuration =
-      (GNSS_configration_t) round(configuration (GNSS_CONFIGURATION));
+  const GNSS_configration_t GNSS_configuration = board::GNSS_from_EEPROM
+      ? (GNSS_configration_t) round(configuration (GNSS_CONFIGURATION))
+      : board::GNSS;
 
   uint8_t count_10Hz = 1; // de-synchronize CAN output by 1 cycle
 
@@ -73,19 +188,32 @@ void communicator_runnable (void*)
     {
       SD_card_to_communicator_synchronizer.wait ();
 
+      uint32_t cycle_start = stage_timestamp();
+      uint32_t t = cycle_start;
+
+      output_data_lock.write_begin(); // record from the player, no sensor latching
       organizer.on_new_pressure_data (output_data); // todo check this update rate
+      t = stage_done( STAGE_PRESSURE, t);
       organizer.update_every_10ms (output_data);
+      t = stage_done( STAGE_10MS, t);
 
       --decimation_counter;
       if( decimation_counter ==0)
 	{
 	  decimation_counter = 10;
 	  organizer.update_GNSS_data (output_data.c);
+	  t = stage_done( STAGE_GNSS, t);
 	  organizer.update_every_100ms (output_data);
+	  t = stage_done( STAGE_100MS, t);
 	  trigger_CAN ();
+	  t = stage_done( STAGE_CAN, t);
 	}
 
       organizer.report_data ( output_data);
+      output_data_lock.write_end();
+      stage_done( STAGE_REPORT, t);
+      stage_done( STAGE_TOTAL, cycle_start);
+      sync_logger (); // request next record from the player
     }
 
 #endif //****************************************************************************************
@@ -94,15 +222,12 @@ void communicator_runnable (void*)
     {
     case GNSS_NONE:
       break;
+#if RUN_GNSS
     case GNSS_M9N:
       {
 	Task usart3_task (USART_3_runnable, "GNSS", 256, (void *)&FALSE, STANDARD_TASK_PRIORITY+1);
 
-	while (!GNSS_new_data_ready) // lousy spin lock !
-	  delay (100);
-
-	organizer.update_GNSS_data (output_data.c);
-	GNSS_new_data_ready = false;
+	wait_for_GNSS_solution (organizer);
       }
       break;
     case GNSS_F9P_F9H: // extra task for 2nd GNSS module required
@@ -113,30 +238,37 @@ void communicator_runnable (void*)
 	    Task usart4_task (USART_4_runnable, "D-GNSS", 256, 0, STANDARD_TASK_PRIORITY + 1);
 	  }
 
-	while (!GNSS_new_data_ready) // lousy spin lock !
-	  delay (100);
-
-	organizer.update_GNSS_data (output_data.c);
-	GNSS_new_data_ready = false;
+	wait_for_GNSS_solution (organizer);
       }
       break;
     case GNSS_F9P_F9P: // no extra task for 2nd GNSS module
       {
 	Task usart3_task (USART_3_runnable, "GNSS", 256, (void *)&TRUE, STANDARD_TASK_PRIORITY+1);
 
-	while (!GNSS_new_data_ready) // lousy spin lock !
-	  delay (100);
-
-	organizer.update_GNSS_data (output_data.c);
-	GNSS_new_data_ready = false;
+	wait_for_GNSS_solution (organizer);
       }
       break;
+#endif
     default:
       ASSERT(false);
     }
 
+  // fix type which lets the status LED blink, decided once instead of every cycle
+  const uint8_t GNSS_fix_for_LED =
+      (GNSS_configuration == GNSS_M9N) ? SAT_FIX
+      : ((GNSS_configuration == GNSS_F9P_F9H) || (GNSS_configuration == GNSS_F9P_F9P)) ? (SAT_HEADING | SAT_FIX)
+      : 0xff; // never
+
   for( int i=0; i<100; ++i) // wait 1 s until measurement stable
-    notify_take (true);
+    {
+      notify_take (true);
+      output_data_lock.write_begin();
+      latch_sensor_data( output_data.m);
+      GNSS_solution_t solution;
+      while( GNSS_solutions.pop( solution)) // keep the coordinates up to date
+	output_data.c = solution.coordinates;
+      output_data_lock.write_end();
+    }
 
   organizer.initialize_after_first_measurement(output_data);
 
@@ -148,31 +280,35 @@ void communicator_runnable (void*)
   while (true)
     {
       notify_take (true); // wait for synchronization by IMU @ 100 Hz
+      timing_cycle_begin();
+
+      uint32_t cycle_start = stage_timestamp();
+      uint32_t t = cycle_start;
 
-      if (GNSS_new_data_ready) // triggered at 10 or 5 Hz, GNSS-dependent
+      output_data_lock.write_begin(); // consumers will not see a half-updated cycle
+      latch_sensor_data( output_data.m);
+      t = stage_done( STAGE_LATCH, t);
+
+      if (consume_GNSS_solutions (organizer)) // triggered at 10 or 5 Hz, GNSS-dependent
 	{
-	  organizer.update_GNSS_data (output_data.c);
-	  GNSS_new_data_ready = false;
 	  synchronizer_10Hz = 1; // NOW: do the 10Hz job, as early as possible !
+	  t = stage_done( STAGE_GNSS, t);
 	}
 
       organizer.on_new_pressure_data(output_data); // todo check this update rate
+      t = stage_done( STAGE_PRESSURE, t);
       organizer.update_every_10ms(output_data);
+      t = stage_done( STAGE_10MS, t);
 
       --synchronizer_10Hz;
       if( synchronizer_10Hz == 0)
 	{
 	  organizer.update_every_100ms (output_data);
 	  synchronizer_10Hz = 10;
+	  t = stage_done( STAGE_100MS, t);
 	}
 
-      if(
-	  (((GNSS_configuration == GNSS_F9P_F9H) || (GNSS_configuration == GNSS_F9P_F9P))
-	      && (output_data.c.sat_fix_type == (SAT_HEADING | SAT_FIX)))
-	  ||
-	  ((GNSS_configuration == GNSS_M9N)
-	      && (output_data.c.sat_fix_type == SAT_FIX))
-	)
+      if( output_data.c.sat_fix_type == GNSS_fix_for_LED)
 	{
 	  ++GNSS_count;
 	  HAL_GPIO_WritePin ( LED_STATUS1_GPIO_Port, LED_STATUS1_Pin,
@@ -208,10 +344,15 @@ void communicator_runnable (void*)
 		  output_data.m.outside_air_temperature = ZERO;
 		}
 	    }
+	  t = stage_done( STAGE_CAN, t);
 	}
 
       organizer.report_data ( output_data);
       sync_logger (); // kick logger @ 100 Hz
+      output_data_lock.write_end();
+      stage_done( STAGE_REPORT, t);
+      stage_done( STAGE_TOTAL, cycle_start);
+      timing_cycle_end();
     }
 }
 
@@ -225,7 +366,12 @@ static ROM TaskParameters_t p =
     {
       { COMMON_BLOCK, COMMON_SIZE,  portMPU_REGION_READ_WRITE },
       { (void*) 0x80f8000, 0x08000, portMPU_REGION_READ_WRITE }, // EEPROM access for MAG calib.
-      { 0, 0, 0 } } };
+#if RUN_DATA_LOGGER
+      { log_ring, LOG_RING_SIZE, portMPU_REGION_READ_WRITE }, // producer side of the logger ring
+#else
+      { 0, 0, 0 }
+#endif
+    } };
 
 COMMON RestrictedTask communicator_task (p);
 
@@ -233,4 +379,7 @@ void
 sync_communicator (void) // global synchronization service function
 {
   communicator_task.notify_give ();
+#if RUN_MS5611_MODULE || RUN_PITOT_MODULE || RUN_FXOS8700
+  i2c_sensors.notify_give (); // I2C sensor batch on the same tick
+#endif
 }
@@ -9,8 +9,47 @@
 #define COMMUNICATOR_H_
 
 #include "data_structures.h"
+#include "seqlock.h"
 //#include "GNSS.h"
 
 extern output_data_t output_data;
+extern seqlock_t output_data_lock; //!< communicator writes output_data, NMEA and CAN read it
+
+//! IMU sample @ 100 Hz
+typedef struct
+{
+  float acc[3];
+  float gyro[3];
+  float mag[3];
+} imu_sample_t;
+
+//! MS5611 static + absolute pressure sensors
+typedef struct
+{
+  float static_pressure;
+  float static_sensor_temperature;
+  float absolute_pressure;
+  float absolute_sensor_temperature;
+} pressure_sample_t;
+
+//! FXOS8700 low-cost acc + mag
+typedef struct
+{
+  float acc[3];
+  float mag[3];
+} lowcost_acc_mag_sample_t;
+
+//! L3GD20 low-cost gyro
+typedef struct
+{
+  float gyro[3];
+} lowcost_gyro_sample_t;
+
+// sensor tasks publish here, the communicator latches the samples at the start of each cycle
+extern seqlocked<imu_sample_t> imu_slot;
+extern seqlocked<pressure_sample_t> pressure_slot;
+extern seqlocked<float> pitot_slot;
+extern seqlocked<lowcost_acc_mag_sample_t> lowcost_acc_mag_slot;
+extern seqlocked<lowcost_gyro_sample_t> lowcost_gyro_slot;
 
 #endif /* COMMUNICATOR_H_ */
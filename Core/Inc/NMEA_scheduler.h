@@ -0,0 +1,75 @@
+/** ***********************************************************************
+ * @file		NMEA_scheduler.h
+ * @brief		per-sentence output rates for the NMEA stream
+ *
+ * Each sentence type has its own period in scheduler ticks.
+ * The formatted sentences are sorted into a pool of fixed slots.
+ * Only the sentences due at the present tick are taken over and
+ * transmitted, all others are skipped.
+ * A set may contain several sentences of one type (e.g. one per
+ * satellite system): the n-th sentence of a type goes into the n-th slot of
+ * that type. The slots of one type share its period.
+ * Host check: Host_tools/NMEA_scheduler_check.cpp
+ **************************************************************************/
+
+#ifndef INC_NMEA_SCHEDULER_H_
+#define INC_NMEA_SCHEDULER_H_
+
+#include "stdint.h"
+
+#define NMEA_SLOTS		16
+#define NMEA_MAX_SENTENCE	128 // Larus extensions exceed the standard 82 characters
+#define NMEA_TYPE_LENGTH	6   // "GPRMC", "PLARV", ...
+
+typedef struct
+{
+  const char * type;	//!< without '$'
+  uint8_t period;	//!< scheduler ticks
+} NMEA_schedule_t;
+
+class NMEA_scheduler
+{
+public:
+  //! sentence types missing in the schedule are sent every default_period ticks
+  NMEA_scheduler( const NMEA_schedule_t * schedule, unsigned entries, uint8_t default_period)
+    : dropped( 0), duplicates( 0), schedule( schedule), entries( entries), default_period( default_period), used( 0)
+  {}
+
+  //! advance one tick, @return true if any sentence is due and the set has to be formatted
+  bool tick( void);
+
+  //! @return true if a sentence of this type is due or has not been seen yet
+  bool is_due( const char * type);
+
+  //! take over the due sentences from a block of formatted sentences
+  void update( const char * sentences, unsigned length);
+
+  //! collect the due sentences, @return length in bytes
+  unsigned compose( char * target, unsigned size);
+
+  uint32_t dropped; //!< sentences too long or without a free slot
+  uint32_t duplicates; //!< additional slots created for repeated sentence types
+private:
+  typedef struct
+  {
+    char type[NMEA_TYPE_LENGTH + 1];
+    uint8_t period;
+    uint8_t countdown;
+    bool due;
+    bool fresh;		//!< text taken over at this tick
+    bool seen;		//!< slot filled from the set being taken over
+    uint8_t length;
+    char text[NMEA_MAX_SENTENCE];
+  } slot_t;
+
+  slot_t * find_slot( const char * type, unsigned type_length);
+  slot_t * new_slot( const char * type, unsigned type_length);
+
+  const NMEA_schedule_t * schedule;
+  unsigned entries;
+  uint8_t default_period;
+  unsigned used;
+  slot_t slots[NMEA_SLOTS];
+};
+
+#endif /* INC_NMEA_SCHEDULER_H_ */
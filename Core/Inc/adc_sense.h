@@ -0,0 +1,34 @@
+/** ***********************************************************************
+ * @file		adc_sense.h
+ * @brief		timer triggered ADC1 scan into a circular DMA buffer
+ *
+ * TIM2 triggers a scan over supply voltage, internal temperature sensor
+ * and Vrefint at ADC_SCAN_RATE_HZ. DMA2 stream 4 writes the results into
+ * a ring of ADC_AVERAGING scans without any interrupt. Readers average
+ * the ring on demand. Vrefint and the factory calibration values yield
+ * the true analog supply instead of the nominal 3.3 V.
+ **************************************************************************/
+
+#ifndef INC_ADC_SENSE_H_
+#define INC_ADC_SENSE_H_
+
+#define ADC_SCAN_RATE_HZ	1000
+#define ADC_AVERAGING		16	// scans, averaging window 16 ms
+
+typedef struct
+{
+  float supply_voltage;		//!< V, board supply behind the 11:1 divider
+  float VDDA;			//!< V, ADC reference from Vrefint
+  float CPU_temperature;	//!< degrees Celsius, die temperature
+} ADC_readings_t;
+
+//! start the scan, privileged, before the scheduler is started
+void ADC_start_scan( void);
+
+//! averaged and calibrated readings of the latest ADC_AVERAGING scans, all channels
+void ADC_get_readings( ADC_readings_t & readings);
+
+//! supply voltage only, for the sensor cycle
+float ADC_get_supply_voltage( void);
+
+#endif /* INC_ADC_SENSE_H_ */
@@ -0,0 +1,113 @@
+/** ***********************************************************************
+ * @file		board_profile.h
+ * @brief		hardware variants: sensors and GNSS setup per board
+ *
+ * Select the variant with BOARD_PROFILE in system_configuration.h.
+ * Each profile defines the RUN_* switches which compile the sensor
+ * drivers and their tasks in or out, and the GNSS setup.
+ * Impossible combinations stop the build.
+ * C++ code can use the constexpr view "board" in plain if statements,
+ * the compiler removes the dead branches.
+ **************************************************************************/
+
+#ifndef INC_BOARD_PROFILE_H_
+#define INC_BOARD_PROFILE_H_
+
+#define BOARD_BENCH		0 // no sensors, replay of logged data
+#define BOARD_LARUS		1 // MTi-1, 2 * MS5611, GNSS setup from EEPROM
+#define BOARD_LARUS_M9N		2 // MTi-1, 2 * MS5611, uBlox M9N on the PCB
+#define BOARD_LARUS_F9P_F9P	3 // MTi-1, 2 * MS5611, D-GNSS 2 * F9P on USART 3
+#define BOARD_LARUS_F9P_F9H	4 // MTi-1, 2 * MS5611, D-GNSS F9P on USART 3, F9H on USART 4
+
+#if BOARD_PROFILE == BOARD_BENCH
+#define RUN_MTi_1_MODULE 	0
+#define RUN_MS5611_MODULE 	0
+#define RUN_L3GD20 		0
+#define RUN_FXOS8700		0
+#define RUN_PITOT_MODULE 	0
+#define RUN_GNSS		0
+#define BOARD_GNSS		GNSS_NONE
+
+#elif BOARD_PROFILE == BOARD_LARUS
+#define RUN_MTi_1_MODULE 	1
+#define RUN_MS5611_MODULE 	1
+#define RUN_L3GD20 		0
+#define RUN_FXOS8700		0
+#define RUN_PITOT_MODULE 	0
+#define RUN_GNSS		1
+#define BOARD_GNSS_FROM_EEPROM	1
+
+#elif BOARD_PROFILE == BOARD_LARUS_M9N
+#define RUN_MTi_1_MODULE 	1
+#define RUN_MS5611_MODULE 	1
+#define RUN_L3GD20 		0
+#define RUN_FXOS8700		0
+#define RUN_PITOT_MODULE 	0
+#define RUN_GNSS		1
+#define BOARD_GNSS		GNSS_M9N
+
+#elif BOARD_PROFILE == BOARD_LARUS_F9P_F9P
+#define RUN_MTi_1_MODULE 	1
+#define RUN_MS5611_MODULE 	1
+#define RUN_L3GD20 		0
+#define RUN_FXOS8700		0
+#define RUN_PITOT_MODULE 	0
+#define RUN_GNSS		1
+#define BOARD_GNSS		GNSS_F9P_F9P
+
+#elif BOARD_PROFILE == BOARD_LARUS_F9P_F9H
+#define RUN_MTi_1_MODULE 	1
+#define RUN_MS5611_MODULE 	1
+#define RUN_L3GD20 		0
+#define RUN_FXOS8700		0
+#define RUN_PITOT_MODULE 	0
+#define RUN_GNSS		1
+#define BOARD_GNSS		GNSS_F9P_F9H
+
+#else
+#error "unknown BOARD_PROFILE"
+#endif
+
+#ifndef BOARD_GNSS_FROM_EEPROM
+#define BOARD_GNSS_FROM_EEPROM	0
+#define BOARD_GNSS_FIXED	BOARD_GNSS
+#else
+#define BOARD_GNSS_FIXED	GNSS_NONE // placeholder, the EEPROM decides
+#endif
+
+// build-time checks
+#if ! RUNNING_PLAYER && ! RUN_MTi_1_MODULE
+#error "live operation needs the MTi-1: its samples trigger the 100 Hz cycle"
+#endif
+
+#if (IMU_OVERSAMPLING != 1) && (IMU_OVERSAMPLING != 2) && (IMU_OVERSAMPLING != 4)
+#error "IMU_OVERSAMPLING: the MTi-1 supports 100, 200 and 400 Hz"
+#endif
+
+#if IMU_OVERSAMPLING > 1 && ! RUN_MTi_1_MODULE
+#error "IMU_OVERSAMPLING needs the MTi-1"
+#endif
+
+#ifdef __cplusplus
+
+//! constexpr view of the selected profile
+struct board
+{
+  static constexpr bool MTi_1		= RUN_MTi_1_MODULE;
+  static constexpr bool MS5611		= RUN_MS5611_MODULE;
+  static constexpr bool L3GD20		= RUN_L3GD20;
+  static constexpr bool FXOS8700	= RUN_FXOS8700;
+  static constexpr bool HCLA_pitot	= RUN_PITOT_MODULE;
+  static constexpr bool I2C_sensors	= MS5611 || FXOS8700 || HCLA_pitot;
+  static constexpr bool GNSS_from_EEPROM = BOARD_GNSS_FROM_EEPROM;
+  static constexpr GNSS_configration_t GNSS = BOARD_GNSS_FIXED; //!< valid if ! GNSS_from_EEPROM
+};
+
+static_assert( board::GNSS_from_EEPROM || board::GNSS == GNSS_NONE || RUN_GNSS,
+	       "the GNSS setup of this board needs RUN_GNSS");
+static_assert( ! board::GNSS_from_EEPROM || RUN_GNSS,
+	       "GNSS setup from EEPROM needs RUN_GNSS");
+
+#endif
+
+#endif /* INC_BOARD_PROFILE_H_ */
@@ -0,0 +1,39 @@
+/** ***********************************************************************
+ * @file		data_logger.h
+ * @brief		ring buffer: communicator -> uSD logger
+ *
+ * Host check: Host_tools/log_ring_check.cpp
+ **************************************************************************/
+
+#ifndef INC_DATA_LOGGER_H_
+#define INC_DATA_LOGGER_H_
+
+#include "stdint.h"
+
+#define LOG_BLOCK_SIZE	2048 // bytes, unit of f_write (), sector aligned
+#define LOG_RING_BLOCKS	4    // 400ms of SD card latency covered
+#define LOG_RING_SIZE	(LOG_RING_BLOCKS * LOG_BLOCK_SIZE) // must be 2^n for the MPU
+#define LOG_SAMPLE_RATE	100 // records per second
+#define LOG_INDEX_INTERVAL	5 // seconds between time index entries
+#define LOG_INDEX_BUFFER_ENTRIES	8 // index entries buffered between two syncs
+#define TIMING_REPORT_INTERVAL_USEC	60000000ULL // stage timing statistics -> *.TIM once per minute
+
+#define LOG_FILE_PREALLOCATION	(150UL * 1024 * 1024) // contiguous cluster chain linked @ start, about 2h of data
+
+//! state of the logger ring, shared by the communicator (producer) and the logger (consumer)
+typedef struct
+{
+  volatile uint32_t write_index;	//!< free-running byte index, only written by the producer
+  volatile uint32_t read_index;		//!< free-running byte index, only written by the consumer
+  volatile bool active;			//!< set by the logger as soon as the output file is open
+  uint32_t dropped_records;		//!< records lost because the ring was full
+  uint32_t max_write_latency_us;	//!< worst-case duration of a block write including f_sync () and index flush
+} log_ring_state_t;
+
+extern uint8_t log_ring[LOG_RING_SIZE];
+extern log_ring_state_t log_ring_state;
+
+//! called by the communicator @ 100 Hz: copy present record into the ring
+extern "C" void sync_logger (void);
+
+#endif /* INC_DATA_LOGGER_H_ */
@@ -0,0 +1,127 @@
+/** ***********************************************************************
+ * @file		fixed_point_format.h
+ * @brief		fast decimal text output, NMEA sentences with running checksum
+ *
+ * Floats are formatted with a compile-time number of decimals.
+ * The binary value is scaled exactly in 64 bit integer arithmetic and
+ * rounded half to even, the result is identical to printf( "%.*f").
+ * Digits are produced in pairs from a table, the divisions by constants
+ * compile into multiplications.
+ * Valid range: |value| * 10^DECIMALS < 2^63, "ovf" is written otherwise.
+ * Host check: Host_tools/fixed_point_format_check.cpp
+ **************************************************************************/
+
+#ifndef INC_FIXED_POINT_FORMAT_H_
+#define INC_FIXED_POINT_FORMAT_H_
+
+#include "stdint.h"
+
+//! decimal unsigned, at least min_digits with leading zeros, @return end of text
+char * format_unsigned( char * next, uint32_t value, unsigned min_digits = 1);
+
+//! decimal signed, at least min_digits with leading zeros, @return end of text
+char * format_signed( char * next, int32_t value, unsigned min_digits = 1);
+
+//! upper case hex, exactly digits characters, @return end of text
+char * format_hex( char * next, uint32_t value, unsigned digits);
+
+//! 10^N at compile time
+template <unsigned N> struct power_of_10
+{
+  static constexpr uint32_t value = 10 * power_of_10<N - 1>::value;
+};
+template <> struct power_of_10<0>
+{
+  static constexpr uint32_t value = 1;
+};
+
+//! handle NaN, infinity and sign, @return scaled |value| rounded, or -1 if text is complete
+int64_t scale_float( char * & next, float value, uint32_t factor);
+
+/*! float with fixed number of decimals
+ *
+ * INTEGER_DIGITS: minimum digits in front of the decimal point, leading zeros
+ */
+template <unsigned DECIMALS, unsigned INTEGER_DIGITS = 1>
+char * format_fixed( char * next, float value)
+{
+  static_assert( DECIMALS <= 6, "float precision exceeded");
+  constexpr uint32_t factor = power_of_10<DECIMALS>::value;
+
+  int64_t scaled = scale_float( next, value, factor);
+  if( scaled < 0)
+    return next;
+
+  uint64_t integer_part;
+  uint32_t fraction;
+  if( (uint64_t)scaled <= UINT32_MAX) // common case: 32 bit constant division -> multiplication
+    {
+      integer_part = (uint32_t)scaled / factor;
+      fraction = (uint32_t)scaled - (uint32_t)integer_part * factor;
+    }
+  else
+    {
+      integer_part = (uint64_t)scaled / factor;
+      fraction = (uint32_t)((uint64_t)scaled - integer_part * factor);
+    }
+
+  if( integer_part <= UINT32_MAX)
+    next = format_unsigned( next, (uint32_t)integer_part, INTEGER_DIGITS);
+  else
+    {
+      next = format_unsigned( next, (uint32_t)(integer_part / 1000000000));
+      next = format_unsigned( next, (uint32_t)(integer_part % 1000000000), 9);
+    }
+
+  if( DECIMALS > 0)
+    {
+      *next++ = '.';
+      next = format_unsigned( next, fraction, DECIMALS);
+    }
+  return next;
+}
+
+//! NMEA sentence builder, the checksum is accumulated while the fields are appended
+class NMEA_sentence
+{
+public:
+  //! start "$<header>"
+  NMEA_sentence( char * buffer, const char * header);
+
+  NMEA_sentence & text( const char * text);
+
+  NMEA_sentence & unsigned_field( uint32_t value, unsigned min_digits = 1)
+  {
+    *next++ = ',';
+    return add( format_unsigned( next, value, min_digits));
+  }
+
+  NMEA_sentence & signed_field( int32_t value)
+  {
+    *next++ = ',';
+    return add( format_signed( next, value));
+  }
+
+  template <unsigned DECIMALS, unsigned INTEGER_DIGITS = 1>
+  NMEA_sentence & fixed_field( float value)
+  {
+    *next++ = ',';
+    return add( format_fixed<DECIMALS, INTEGER_DIGITS>( next, value));
+  }
+
+  //! append "*<checksum>\r\n" and a terminating zero, @return end of sentence (at the zero)
+  char * finish( void);
+private:
+  NMEA_sentence & add( char * end)
+  {
+    for( const char * p = checksummed; p < end; ++p)
+      checksum ^= (uint8_t)*p;
+    checksummed = next = end;
+    return *this;
+  }
+  char * next;
+  char * checksummed;
+  uint8_t checksum;
+};
+
+#endif /* INC_FIXED_POINT_FORMAT_H_ */
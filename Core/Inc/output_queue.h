@@ -0,0 +1,66 @@
+/** ***********************************************************************
+ * @file		output_queue.h
+ * @brief		byte queue feeding one asynchronous output channel
+ *
+ * Each output channel (USB, Bluetooth, USARTs) gets its own queue.
+ * The producer task appends complete blocks of sentences, the channel's
+ * transfer-complete ISR releases the transmitted bytes and starts the next
+ * transfer directly from the queue memory. A congested channel only loses
+ * its own data.
+ * DROP_OLDEST cuts the queue only behind a line end: a transfer ending at the
+ * buffer wrap-around may stop within a sentence, its rest is always kept.
+ * A completion that never comes (USB detached, UART DMA error) would block
+ * the queue forever: the producer reports the channel state via recover().
+ * The size must be a power of 2: the free-running counters wrap at 2^32.
+ **************************************************************************/
+
+#ifndef INC_OUTPUT_QUEUE_H_
+#define INC_OUTPUT_QUEUE_H_
+
+#include "stdint.h"
+
+enum drop_policy_t
+{
+  DROP_NEWEST,	//!< queue full: discard the new block, continuous stream
+  DROP_OLDEST	//!< queue full: discard everything not yet in transfer, lowest latency
+};
+
+//! start an asynchronous transfer, @return false if the channel did not accept it
+typedef bool (*start_transfer_t)( uint8_t * data, uint16_t size);
+
+class output_queue
+{
+public:
+  output_queue( uint8_t * buffer, unsigned size, drop_policy_t policy, start_transfer_t start_transfer)
+    : overflows( 0), dropped_bytes( 0), refused_transfers( 0), lost_transfers( 0),
+      buffer( buffer), size( size), policy( policy), start_transfer( start_transfer),
+      write_count( 0), read_count( 0), in_flight( 0)
+  {}
+
+  //! producer task: append a block of complete sentences
+  void write( const char * data, unsigned length);
+
+  //! transfer-complete ISR: release the transmitted bytes, start the next transfer
+  void on_transfer_complete( void);
+
+  //! producer task: channel_idle = no transfer running, a pending one is given up
+  void recover( bool channel_idle);
+
+  uint32_t overflows;		//!< blocks that found the queue full
+  uint32_t dropped_bytes;
+  uint32_t refused_transfers;	//!< channel busy or not ready, retried with the next block
+  uint32_t lost_transfers;	//!< transfers without completion, released by recover()
+private:
+  void start_next( void); //!< interrupts masked or ISR context
+
+  uint8_t * buffer;
+  unsigned size;
+  drop_policy_t policy;
+  start_transfer_t start_transfer;
+  // free-running byte counters
+  volatile uint32_t write_count;
+  volatile uint32_t read_count;	//!< transmitted completely
+  volatile uint32_t in_flight;	//!< handed to the hardware, starting at read_count
+};
+
+#endif /* INC_OUTPUT_QUEUE_H_ */
@@ -0,0 +1,83 @@
+/** ***********************************************************************
+ * @file		seqlock.h
+ * @brief		sequence lock: one writer, many readers, no blocking of the writer
+ *
+ * Host check: Host_tools/seqlock_check.cpp
+ **************************************************************************/
+
+#ifndef INC_SEQLOCK_H_
+#define INC_SEQLOCK_H_
+
+#include "stdint.h"
+#include "cmsis_compiler.h"
+#include "FreeRTOS_wrapper.h"
+
+//! sequence counter: odd while the writer is active
+class seqlock_t
+{
+public:
+  void write_begin( void)
+  {
+    sequence = sequence + 1;
+    __DMB();
+  }
+  void write_end( void)
+  {
+    __DMB();
+    sequence = sequence + 1;
+  }
+
+  //! wait until no write is in progress, @return sequence to be checked by read_retry()
+  uint32_t read_begin( void) const
+  {
+    uint32_t s;
+    while( (s = sequence) & 1)
+      delay( 1); // writer has been preempted, let it complete
+    __DMB();
+    return s;
+  }
+
+  //! @return true if the data have been modified while reading
+  bool read_retry( uint32_t s) const
+  {
+    __DMB();
+    return s != sequence;
+  }
+
+  //! @return present sequence without waiting
+  uint32_t snapshot( void) const
+  {
+    uint32_t s = sequence;
+    __DMB();
+    return s;
+  }
+private:
+  volatile uint32_t sequence;
+};
+
+//! sample slot written by one sensor task and latched by the communicator
+template <class T> class seqlocked
+{
+public:
+  void publish( const T & value)
+  {
+    lock.write_begin();
+    data = value;
+    lock.write_end();
+  }
+
+  //! @return false if nothing published yet or the writer is active, target unusable then
+  bool try_read( T & target) const
+  {
+    uint32_t s = lock.snapshot();
+    if( (s == 0) || (s & 1))
+      return false;
+    target = data;
+    return ! lock.read_retry( s);
+  }
+private:
+  T data;
+  seqlock_t lock;
+};
+
+#endif /* INC_SEQLOCK_H_ */
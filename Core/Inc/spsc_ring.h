@@ -0,0 +1,59 @@
+/** ***********************************************************************
+ * @file		spsc_ring.h
+ * @brief		lock-free ring buffer: one producer task, one consumer task
+ *
+ * Host check: Host_tools/spsc_ring_check.cpp
+ **************************************************************************/
+
+#ifndef INC_SPSC_RING_H_
+#define INC_SPSC_RING_H_
+
+#include "stdint.h"
+#include "cmsis_compiler.h"
+
+//! FIFO of SIZE entries, SIZE must be a power of 2
+template <class T, unsigned SIZE> class spsc_ring
+{
+  static_assert( (SIZE & (SIZE - 1)) == 0, "ring size must be a power of 2");
+public:
+  //! producer side, @return false if the ring is full, value dropped then
+  bool push( const T & value)
+  {
+    uint32_t w = write_count;
+    if( w - read_count >= SIZE)
+      {
+	++overruns;
+	return false;
+      }
+    buffer[w % SIZE] = value;
+    __DMB(); // entry complete before it becomes visible
+    write_count = w + 1;
+    return true;
+  }
+
+  //! consumer side, @return false if the ring is empty
+  bool pop( T & target)
+  {
+    uint32_t r = read_count;
+    if( r == write_count)
+      return false;
+    __DMB();
+    target = buffer[r % SIZE];
+    __DMB(); // entry copied before the producer may overwrite it
+    read_count = r + 1;
+    return true;
+  }
+
+  bool is_empty( void) const
+  {
+    return read_count == write_count;
+  }
+
+  uint32_t overruns; //!< entries dropped because the consumer has been too slow
+private:
+  T buffer[SIZE];
+  volatile uint32_t write_count; //!< written by the producer only
+  volatile uint32_t read_count;  //!< written by the consumer only
+};
+
+#endif /* INC_SPSC_RING_H_ */
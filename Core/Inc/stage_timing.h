@@ -0,0 +1,139 @@
+/** ***********************************************************************
+ * @file		stage_timing.h
+ * @brief		execution time statistics of the 100 Hz processing stages and IMU DRDY timing
+ **************************************************************************/
+
+#ifndef INC_STAGE_TIMING_H_
+#define INC_STAGE_TIMING_H_
+
+#include "system_configuration.h"
+#include "stdint.h"
+
+#define CPU_CYCLES_PER_USEC	168
+#define CYCLE_DEADLINE_USEC	10000 // 100 Hz
+#define TIMING_HISTOGRAM_BINS	16 // bin n: 2^n us <= t < 2^(n+1) us, last bin: more
+
+enum timing_stage_t
+{
+  STAGE_LATCH,		//!< sensor sample latching
+  STAGE_GNSS,		//!< update_GNSS_data
+  STAGE_PRESSURE,	//!< on_new_pressure_data
+  STAGE_10MS,		//!< update_every_10ms
+  STAGE_100MS,		//!< update_every_100ms
+  STAGE_CAN,		//!< CAN trigger and air density data
+  STAGE_REPORT,		//!< report_data + logger
+  STAGE_TOTAL,		//!< whole cycle
+  STAGE_COUNT
+};
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t sum_cycles;
+  uint32_t histogram[TIMING_HISTOGRAM_BINS];
+} stage_statistics_t;
+
+#define DRDY_PERIOD_USEC	(10000 / IMU_OVERSAMPLING) // IMU data ready @ 100 Hz * IMU_OVERSAMPLING
+#define JITTER_DECAY_SAMPLES	(6000 * IMU_OVERSAMPLING)  // halve the jitter histogram once a minute
+
+//! IMU data-ready (DRDY) timing, maintained by the EXTI ISR
+typedef struct
+{
+  uint64_t last_drdy_usec;
+  uint32_t overruns;		//!< DRDY while the communicator was still busy
+  uint32_t missed_cycles;	//!< DRDY periods without any DRDY
+  uint32_t imu_restarts;	//!< IMU re-initializations after DRDY timeout
+  uint32_t max_jitter_usec;	//!< worst |interval - period| within the present decay period
+  uint32_t decay_counter;
+  uint32_t phase;		//!< DRDY count within one communicator cycle when oversampling
+  uint32_t jitter_histogram[TIMING_HISTOGRAM_BINS]; //!< |interval - period|, same bins as stages
+  volatile bool armed;		//!< IMU in measurement mode
+  volatile bool first_sample;	//!< next DRDY only starts the interval measurement
+  volatile bool communicator_busy;
+} drdy_statistics_t;
+
+typedef struct
+{
+  stage_statistics_t stage[STAGE_COUNT];
+  uint32_t deadline_misses; //!< cycles taking longer than CYCLE_DEADLINE_USEC
+  drdy_statistics_t drdy;
+} loop_timing_t;
+
+#define TIMING_REPORT_LINES	(STAGE_COUNT + 2) // stages, counters, jitter histogram
+
+extern loop_timing_t loop_timing;
+extern const char * const timing_stage_names[STAGE_COUNT];
+
+uint32_t get_cycle_count(void);
+
+#if MEASURE_STAGE_TIMING
+
+//! @return time stamp to start a stage measurement
+inline uint32_t stage_timestamp( void)
+{
+  return get_cycle_count();
+}
+
+//! account time since start for stage, @return time stamp for the next stage
+uint32_t stage_done( timing_stage_t stage, uint32_t start);
+
+//! DRDY interrupt: account interval, called from ISR
+void timing_on_DRDY( uint64_t time_usec);
+
+//! communicator starts processing a sample
+inline void timing_cycle_begin( void)
+{
+  loop_timing.drdy.communicator_busy = true;
+}
+
+//! communicator has completed the cycle
+inline void timing_cycle_end( void)
+{
+  loop_timing.drdy.communicator_busy = false;
+}
+
+//! IMU measurement mode entered: from now on DRDY is expected every DRDY_PERIOD_USEC
+inline void timing_arm_DRDY( void)
+{
+  loop_timing.drdy.phase = 0;
+  loop_timing.drdy.first_sample = true;
+  loop_timing.drdy.armed = true;
+}
+
+//! IMU is re-initialized
+inline void timing_on_IMU_restart( void)
+{
+  loop_timing.drdy.armed = false;
+  ++loop_timing.drdy.imu_restarts;
+}
+
+#else
+
+inline uint32_t stage_timestamp( void)
+{
+  return 0;
+}
+
+inline uint32_t stage_done( timing_stage_t, uint32_t)
+{
+  return 0;
+}
+
+inline void timing_on_DRDY( uint64_t) {}
+inline void timing_cycle_begin( void) {}
+inline void timing_cycle_end( void) {}
+inline void timing_arm_DRDY( void) {}
+inline void timing_on_IMU_restart( void) {}
+
+#endif
+
+//! format line 0 .. TIMING_REPORT_LINES-1 of the text report, times in us
+char * format_timing_report_line( char * next, unsigned line);
+
+//! format proprietary NMEA sentence $PLART: worst-case stage times / us, deadline misses,
+//! DRDY overruns, missed cycles, IMU restarts, max. jitter / us
+char * format_timing_sentence( char * next);
+
+#endif /* INC_STAGE_TIMING_H_ */
@@ -17,11 +17,13 @@ extern float * probe; // debugging probes
 
 #define WRITE_MAG_CALIB_EEPROM		0
 #define LOG_MAGNETIC_CALIBRATION 	1
+#define LOG_COMPRESSION			0 // 1: write compressed .c50 log files, 0: raw .h50
 #define WRITE_EEPROM_DEFAULTS		0
 #define USE_HARDWARE_EEPROM		1
 #define WITH_DENSITY_DATA		1
 #define WITH_LOWCOST_SENSORS		1
 #define USE_LARUS_NMEA_EXTENSIONS	1
+#define MEASURE_STAGE_TIMING		1 // execution time statistics of the 100 Hz loop, $PLART sentence, *.TIM file
 
 #define GNSS_VERTICAL_SPEED_INVERTED	0 // for simulation with old data
 
@@ -33,12 +35,15 @@ extern float * probe; // debugging probes
 
 #define ACTIVATE_USB_NMEA	1
 
-#define RUN_GNSS		0
-#define RUN_MTi_1_MODULE 	0
-#define RUN_MS5611_MODULE 	0
-#define RUN_L3GD20 		0
-#define RUN_FXOS8700		0
-#define RUN_PITOT_MODULE 	0
+#define BOARD_PROFILE		BOARD_BENCH // hardware variant: sensors, GNSS setup, see board_profile.h
+
+#define GNSS_CONFIGURE_RECEIVER	1 // push CFG-VALSET at boot, 0: receiver configured by u-center
+#define GNSS_DEFAULT_BAUDRATE	115200 // receiver flash setting
+#define GNSS_BAUDRATE		460800 // after configuration, 921600 is beyond the APB1 baud rate accuracy
+#define GNSS_OUTPUT_LATENCY_USEC 25000 // receiver epoch -> end of transmission, not observable without PPS
+#define GNSS_LATENCY_COMPENSATION 1 // organizer gets the GNSS position extrapolated to the IMU sample time
+#define IMU_OVERSAMPLING	1 // 1: MTi-1 @ 100 Hz, 4: @ 400 Hz, anti-alias filtered and decimated to 100 Hz
+#define PRESSURE_PREFILTER	1 // median spike rejection + low-pass at the raw sensor rate, see pressure_prefilter.h
 
 #define RUN_CAN_TESTER		0
 #define TEST_EEPROM		0
@@ -59,9 +64,8 @@ extern float * probe; // debugging probes
 
 #define MTI_PRIORITY		STANDARD_TASK_PRIORITY + 3
 
-#define MS5611_PRIORITY		STANDARD_TASK_PRIORITY + 2
+#define I2C_SENSORS_PRIORITY	STANDARD_TASK_PRIORITY + 2 // MS5611, HCLA pitot, FXOS8700
 #define L3GD20_PRIORITY		STANDARD_TASK_PRIORITY + 2
-#define PITOT_PRIORITY		STANDARD_TASK_PRIORITY + 2
 
 #define COMMUNICATOR_PRIORITY	STANDARD_TASK_PRIORITY + 2
 
@@ -76,12 +80,16 @@ extern float * probe; // debugging probes
 #define SDIO_ISR_PRIORITY	14
 #define STANDARD_ISR_PRIORITY	15 // lowest priority
 
-#define NMEA_REPORTING_PERIOD	250 // period in clock ticks for NMEA output
+#define NMEA_REPORTING_PERIOD	100 // NMEA scheduler tick in clock ticks, sentence periods: NMEA_Output.cpp
 
 #define ACTIVATE_FPU_EXCEPTION_TRAP 0 // todo I want to be SET !
 #define SET_FPU_FLUSH_TO_ZERO	1
 #define ACTIVATE_WATCHDOG	0
 #define WATCHDOG_STATISTICS 	0
 #define RUNNING_PLAYER		1
+#define PLAYER_REAL_TIME	0 // 1: replay @ 100Hz, 0: replay as fast as the communicator can process
+#define PLAYER_START_TIME	0 // UTC time of day / s where the replay starts, 0: from the beginning
+
+#include "board_profile.h" // after all switches: the profile checks them
 
 #endif /* SRC_SYSTEM_CONFIGURATION_H_ */
@@ -28,8 +28,10 @@ static void runnable (void*)
   for( synchronous_timer t(10); true; t.sync())
     {
       L3GD20_ReadData (gyro_xyz);
+      lowcost_gyro_sample_t sample;
       for (int i = 0; i < 3; i++)
-	 output_data.m.lowcost_gyro[i] = gyro_xyz[i] * SCALING;
+	 sample.gyro[i] = gyro_xyz[i] * SCALING;
+      lowcost_gyro_slot.publish( sample);
     }
 }
 
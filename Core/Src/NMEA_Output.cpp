@@ -12,9 +12,91 @@
 #include "uart6.h"
 #include "communicator.h"
 #include "system_state.h"
+#include "stage_timing.h"
+#include "NMEA_scheduler.h"
+#include "output_queue.h"
+#include "usbd_cdc_if.h"
+
+COMMON string_buffer_t NMEA_buf; //!< due sentences, transmitted
+static string_buffer_t NMEA_formatted; //!< complete sentence set
+
+#define TIMING_SENTENCE_SIZE		100
+
+/*! sentence periods in units of NMEA_REPORTING_PERIOD
+ *
+ * format_NMEA_string() formats the complete library sentence set at once,
+ * so each tick with any library sentence due costs a full formatting run.
+ * All periods are multiples of 2: the set is formatted @ 5 Hz at most.
+ * Only $PLART, formatted here, is produced when it is due.
+ */
+static ROM NMEA_schedule_t NMEA_schedule[] =
+{
+    { "PLARV", 2 },	// vario 5 Hz
+    { "POV", 2 },	// OpenVario: vario, TAS, pressures
+    { "GPRMC", 4 },	// position 2.5 Hz
+    { "GPGGA", 4 },
+    { "PLART", 50 },	// stage timing every 5 s
+};
+#define NMEA_DEFAULT_PERIOD 2 // all other sentences 5 Hz
+
+static NMEA_scheduler scheduler( NMEA_schedule, sizeof( NMEA_schedule) / sizeof( NMEA_schedule_t), NMEA_DEFAULT_PERIOD);
 
-COMMON string_buffer_t NMEA_buf;
 extern USBD_HandleTypeDef hUsbDeviceFS; // from usb_device.c
+extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart2;
+
+#define NMEA_QUEUE_SIZE 1024 // per channel, >= 2 NMEA periods
+static_assert( (NMEA_QUEUE_SIZE & (NMEA_QUEUE_SIZE - 1)) == 0, "output_queue needs a power of 2 size");
+
+#if ACTIVATE_USB_NMEA
+static bool USB_start_transfer( uint8_t * data, uint16_t size)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  if( hcdc == 0 || hcdc->TxState != 0) // not enumerated or host not reading
+    return false;
+  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, data, size);
+  return USBD_CDC_TransmitPacket(&hUsbDeviceFS) == USBD_OK;
+}
+static bool USB_idle( void) // detached or transfer finished
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  return hcdc == 0 || hcdc->TxState == 0;
+}
+static uint8_t USB_queue_buffer[NMEA_QUEUE_SIZE];
+static output_queue USB_queue( USB_queue_buffer, NMEA_QUEUE_SIZE, DROP_OLDEST, USB_start_transfer);
+static void USB_transfer_complete( void)
+{
+  USB_queue.on_transfer_complete();
+}
+#endif
+
+#if ACTIVATE_BLUETOOTH_NMEA
+static uint8_t bluetooth_queue_buffer[NMEA_QUEUE_SIZE];
+static output_queue bluetooth_queue( bluetooth_queue_buffer, NMEA_QUEUE_SIZE, DROP_OLDEST, Bluetooth_Transmit_IT);
+static void bluetooth_transfer_complete( void)
+{
+  bluetooth_queue.on_transfer_complete();
+}
+#endif
+
+// the serial ports feed flight computers: no reordering, drop only what does not fit
+#if ACTIVATE_USART_1_NMEA
+static uint8_t USART_1_queue_buffer[NMEA_QUEUE_SIZE];
+static output_queue USART_1_queue( USART_1_queue_buffer, NMEA_QUEUE_SIZE, DROP_NEWEST, USART_1_transmit_DMA);
+static void USART_1_transfer_complete( void)
+{
+  USART_1_queue.on_transfer_complete();
+}
+#endif
+
+#if ACTIVATE_USART_2_NMEA
+static uint8_t USART_2_queue_buffer[NMEA_QUEUE_SIZE];
+static output_queue USART_2_queue( USART_2_queue_buffer, NMEA_QUEUE_SIZE, DROP_NEWEST, USART_2_transmit_DMA);
+static void USART_2_transfer_complete( void)
+{
+  USART_2_queue.on_transfer_complete();
+}
+#endif
 
 static void runnable (void* data)
 {
@@ -38,25 +120,63 @@ static void runnable (void* data)
   update_system_state_set( BLUEZ_OUTPUT_ACTIVE);
 #endif
 
+#if ACTIVATE_USB_NMEA
+  CDC_transmit_complete_handler = USB_transfer_complete;
+#endif
+#if ACTIVATE_BLUETOOTH_NMEA
+  UART_set_transmit_complete_handler( &huart6, bluetooth_transfer_complete); // after the blocking configuration
+#endif
+#if ACTIVATE_USART_1_NMEA
+  UART_set_transmit_complete_handler( &huart1, USART_1_transfer_complete);
+#endif
+#if ACTIVATE_USART_2_NMEA
+  UART_set_transmit_complete_handler( &huart2, USART_2_transfer_complete);
+#endif
+
   suspend(); // wait until we are needed
 
   for (synchronous_timer t (NMEA_REPORTING_PERIOD); true; t.sync ())
     {
+      if( scheduler.tick())
+	{
+	  uint32_t sequence;
+	  do // format again if the communicator has updated output_data meanwhile
+	    {
+	      sequence = output_data_lock.read_begin();
+	      format_NMEA_string( output_data, NMEA_formatted);
+	    }
+	  while( output_data_lock.read_retry( sequence));
+
+#if MEASURE_STAGE_TIMING
+	  static_assert( sizeof( NMEA_formatted.string) > TIMING_SENTENCE_SIZE, "NMEA buffer must be an array");
+	  if( scheduler.is_due( "PLART") && (NMEA_formatted.length + TIMING_SENTENCE_SIZE < sizeof( NMEA_formatted.string)))
+	    NMEA_formatted.length = format_timing_sentence( NMEA_formatted.string + NMEA_formatted.length) - NMEA_formatted.string;
+#endif
+	  scheduler.update( NMEA_formatted.string, NMEA_formatted.length);
+	}
 
-      format_NMEA_string( output_data, NMEA_buf);
+      NMEA_buf.length = scheduler.compose( NMEA_buf.string, sizeof( NMEA_buf.string));
+      if( NMEA_buf.length == 0)
+	continue;
 
+      // each channel copies into its own queue, NMEA_buf may be reused immediately
+      // a channel found idle with a transfer pending has lost its completion: release it
 #if ACTIVATE_USB_NMEA
-      USBD_CDC_SetTxBuffer(&hUsbDeviceFS, (uint8_t *)NMEA_buf.string, NMEA_buf.length);
-      USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+      USB_queue.recover( USB_idle());
+      USB_queue.write( NMEA_buf.string, NMEA_buf.length);
 #endif
 #if ACTIVATE_BLUETOOTH_NMEA
-      Bluetooth_Transmit( (uint8_t *)(NMEA_buf.string), NMEA_buf.length);
+      bluetooth_queue.recover( huart6.gState == HAL_UART_STATE_READY);
+      if( Bluetooth_connected())
+	bluetooth_queue.write( NMEA_buf.string, NMEA_buf.length);
 #endif
 #if ACTIVATE_USART_1_NMEA
-      USART_1_transmit_DMA( (uint8_t *)(NMEA_buf.string), NMEA_buf.length);
+      USART_1_queue.recover( huart1.gState == HAL_UART_STATE_READY); // DMA error: HAL has aborted the transfer
+      USART_1_queue.write( NMEA_buf.string, NMEA_buf.length);
 #endif
 #if ACTIVATE_USART_2_NMEA
-      USART_2_transmit_DMA( (uint8_t *)(NMEA_buf.string), NMEA_buf.length);
+      USART_2_queue.recover( huart2.gState == HAL_UART_STATE_READY);
+      USART_2_queue.write( NMEA_buf.string, NMEA_buf.length);
 #endif
     }
 }
@@ -0,0 +1,163 @@
+/** ***********************************************************************
+ * @file		NMEA_scheduler.cpp
+ * @brief		per-sentence output rates for the NMEA stream
+ **************************************************************************/
+
+#include "NMEA_scheduler.h"
+
+static bool same_type( const char * a, const char * b, unsigned length)
+{
+  for( unsigned i = 0; i < length; ++i)
+    if( a[i] != b[i])
+      return false;
+  return b[length] == 0;
+}
+
+bool NMEA_scheduler::tick( void)
+{
+  bool any_due = (used == 0); // nothing known yet
+  for( unsigned i = 0; i < used; ++i)
+    {
+      slot_t & slot = slots[i];
+      if( slot.countdown > 1)
+	--slot.countdown;
+      else
+	{
+	  slot.countdown = slot.period;
+	  slot.due = true;
+	  any_due = true;
+	}
+    }
+  return any_due;
+}
+
+bool NMEA_scheduler::is_due( const char * type)
+{
+  unsigned type_length = 0;
+  while( type[type_length] != 0)
+    ++type_length;
+
+  for( unsigned i = 0; i < used; ++i)
+    if( same_type( type, slots[i].type, type_length))
+      return slots[i].due;
+  return true; // first occurrence will be sent right now
+}
+
+NMEA_scheduler::slot_t * NMEA_scheduler::find_slot( const char * type, unsigned type_length)
+{
+  for( unsigned i = 0; i < used; ++i)
+    if( ! slots[i].seen && same_type( type, slots[i].type, type_length))
+      return &slots[i];
+  return new_slot( type, type_length);
+}
+
+NMEA_scheduler::slot_t * NMEA_scheduler::new_slot( const char * type, unsigned type_length)
+{
+  if( used >= NMEA_SLOTS)
+    return 0;
+
+  // a repeated type is inserted behind its last slot and takes over its phase
+  unsigned position = used;
+  bool repeated = false;
+  for( unsigned i = 0; i < used; ++i)
+    if( same_type( type, slots[i].type, type_length))
+      {
+	position = i + 1;
+	repeated = true;
+      }
+
+  for( unsigned i = used; i > position; --i)
+    slots[i] = slots[i - 1];
+  ++used;
+
+  slot_t & slot = slots[position];
+  if( repeated)
+    {
+      slot = slots[position - 1];
+      slot.fresh = false;
+      slot.seen = false;
+      ++duplicates;
+      return &slot;
+    }
+
+  // new sentence type: send it right now, then with its scheduled period
+  for( unsigned i = 0; i < type_length; ++i)
+    slot.type[i] = type[i];
+  slot.type[type_length] = 0;
+
+  slot.period = default_period;
+  for( unsigned i = 0; i < entries; ++i)
+    if( same_type( type, schedule[i].type, type_length))
+      slot.period = schedule[i].period;
+
+  slot.countdown = slot.period;
+  slot.due = true;
+  slot.fresh = false;
+  slot.seen = false;
+  return &slot;
+}
+
+void NMEA_scheduler::update( const char * sentences, unsigned length)
+{
+  const char * end = sentences + length;
+  const char * next = sentences;
+
+  for( unsigned i = 0; i < used; ++i)
+    slots[i].seen = false;
+
+  while( next < end)
+    {
+      if( *next != '$')
+	{
+	  ++next;
+	  continue;
+	}
+
+      const char * start = next++;
+      while( next < end && *next != '$' && next[-1] != '\n')
+	++next;
+
+      const char * type = start + 1;
+      unsigned type_length = 0;
+      while( type_length < NMEA_TYPE_LENGTH && type + type_length < next
+	  && type[type_length] != ',' && type[type_length] != '*')
+	++type_length;
+
+      unsigned sentence_length = next - start;
+      slot_t * slot = sentence_length <= NMEA_MAX_SENTENCE ? find_slot( type, type_length) : 0;
+      if( slot == 0)
+	{
+	  ++dropped;
+	  continue;
+	}
+
+      slot->seen = true;
+
+      if( ! slot->due)
+	continue; // not copied: only the due sentences cost time
+
+      for( unsigned i = 0; i < sentence_length; ++i)
+	slot->text[i] = start[i];
+      slot->length = (uint8_t)sentence_length;
+      slot->fresh = true;
+    }
+}
+
+unsigned NMEA_scheduler::compose( char * target, unsigned size)
+{
+  unsigned length = 0;
+  for( unsigned i = 0; i < used; ++i)
+    {
+      slot_t & slot = slots[i];
+      if( slot.fresh && length + slot.length <= size)
+	{
+	  for( unsigned k = 0; k < slot.length; ++k)
+	    target[length + k] = slot.text[k];
+	  length += slot.length;
+	}
+      // a due sentence the formatter has not delivered this time is not repeated
+      slot.fresh = false;
+      slot.due = false;
+    }
+  return length;
+}
@@ -16,6 +16,12 @@
 #include "read_configuration_file.h"
 #include "communicator.h"
 #include "system_state.h"
+#include "data_logger.h"
+#include "log_compression.h"
+#include "log_format.h"
+#include "stage_timing.h"
+#include "adc_sense.h"
+#include "fixed_point_format.h"
 
 extern Semaphore SD_card_to_communicator_synchronizer;
 extern bool replaying_data;
@@ -34,9 +40,212 @@ extern DMA_HandleTypeDef hdma_sdio_rx;
 extern DMA_HandleTypeDef hdma_sdio_tx;
 extern int64_t FAT_time; //!< DOS FAT time for file usage
 
-#define BUFSIZE 2048 // bytes
-#define RESERVE 512
-static uint8_t __ALIGNED(BUFSIZE) buffer[BUFSIZE + RESERVE];
+#define RECORD_SIZE (sizeof(measurement_data_t)+sizeof(coordinates_t))
+
+uint8_t __ALIGNED(LOG_RING_SIZE) log_ring[LOG_RING_SIZE]; // communicator task gets an MPU region for this
+COMMON log_ring_state_t log_ring_state;
+
+uint64_t getTime_usec(void);
+
+//! copy data out of the ring, handles wrap-around
+static void copy_from_ring( void * target, uint32_t index, uint32_t size)
+{
+  uint32_t offset = index % LOG_RING_SIZE;
+  uint32_t first_part = LOG_RING_SIZE - offset;
+  if( first_part > size)
+    first_part = size;
+  memcpy( target, log_ring + offset, first_part);
+  memcpy( (uint8_t *)target + first_part, log_ring, size - first_part);
+}
+
+//! @return GNSS time of day in ms
+static uint32_t day_time_ms( const coordinates_t & c)
+{
+  int32_t time = ((c.hour * 60 + c.minute) * 60 + c.second) * 1000;
+#if INCLUDING_NANO
+  time += c.nano / 1000000;
+#endif
+  return time < 0 ? 0 : (uint32_t)time;
+}
+
+static uint32_t ring_origin;		//!< ring index of record #0
+static uint32_t next_index_record;	//!< next record to be put into the time index
+static log_index_entry_t block_index;	//!< index entry for the block being prepared
+static bool block_indexed;		//!< true if block_index is valid
+
+#if LOG_COMPRESSION
+
+static_assert( LOG_COMPRESSED_BLOCK_SIZE == LOG_BLOCK_SIZE, "f_write () unit mismatch");
+static uint8_t __ALIGNED(4) compressed_block[LOG_COMPRESSED_BLOCK_SIZE];
+static const log_quantization quantization( log_channels, log_channel_count);
+static log_block_encoder encoder( compressed_block, quantization);
+
+//! compress records from the ring until a block is complete
+//! @return completed block or 0 if the ring has been drained
+static const uint8_t * next_log_block( void)
+{
+  uint32_t record[LOG_RECORD_WORDS];
+  while( log_ring_state.write_index - log_ring_state.read_index >= RECORD_SIZE)
+    {
+      copy_from_ring( record, log_ring_state.read_index, RECORD_SIZE);
+
+      bool first_of_block = encoder.is_empty();
+      if( ! encoder.append( record))
+	{
+	  encoder.finish(); // record remains in the ring and starts the next block
+	  return compressed_block;
+	}
+
+      uint32_t record_number = (log_ring_state.read_index - ring_origin) / RECORD_SIZE;
+      if( first_of_block && (record_number >= next_index_record))
+	{
+	  block_index.day_time_ms = day_time_ms( *(const coordinates_t *)((uint8_t *)record + sizeof( measurement_data_t)));
+	  block_index.record = record_number;
+	  block_index.offset = 0; // file position known when the block is written
+	  block_indexed = true;
+	}
+
+      log_ring_state.read_index += RECORD_SIZE;
+    }
+  return 0;
+}
+
+//! block has been written
+static void release_log_block( void)
+{
+  encoder.start();
+}
+
+#else
+
+//! @return next complete block within the ring or 0 if none available
+static const uint8_t * next_log_block( void)
+{
+  if( log_ring_state.write_index - log_ring_state.read_index < LOG_BLOCK_SIZE)
+    return 0;
+
+  // first record starting within this block
+  uint32_t record_number = (log_ring_state.read_index - ring_origin + RECORD_SIZE - 1) / RECORD_SIZE;
+  if( record_number >= next_index_record)
+    {
+      coordinates_t c;
+      copy_from_ring( &c, ring_origin + record_number * RECORD_SIZE + sizeof( measurement_data_t), sizeof( c));
+      block_index.day_time_ms = day_time_ms( c);
+      block_index.record = record_number;
+      block_index.offset = LOG_HEADER_SIZE + record_number * RECORD_SIZE;
+      block_indexed = true;
+    }
+
+  return log_ring + (log_ring_state.read_index % LOG_RING_SIZE);
+}
+
+//! block has been written and may be re-used now
+static void release_log_block( void)
+{
+  log_ring_state.read_index += LOG_BLOCK_SIZE;
+}
+
+#endif
+
+static FIL index_file; //!< time index of the log file, used by the player to seek as well
+static bool index_file_is_open;
+static log_index_entry_t index_buffer[LOG_INDEX_BUFFER_ENTRIES];
+static unsigned index_entries;
+
+//! remember index entry of the block just written
+static void add_index_entry( FSIZE_t block_offset)
+{
+  if( ! block_indexed)
+    return;
+  block_indexed = false;
+
+  if( block_index.offset == 0)
+    block_index.offset = block_offset;
+  next_index_record = block_index.record + LOG_INDEX_INTERVAL * LOG_SAMPLE_RATE;
+
+  if( index_entries < LOG_INDEX_BUFFER_ENTRIES)
+    index_buffer[index_entries++] = block_index;
+}
+
+static log_index_header_t index_header = { LOG_INDEX_MAGIC, LOG_INDEX_VERSION, sizeof( log_index_entry_t), 0};
+
+//! append the buffered index entries and record the synchronized size of the log file
+static void flush_index( FSIZE_t log_size)
+{
+  if( ! index_file_is_open)
+    {
+      index_entries = 0;
+      return;
+    }
+
+  UINT writtenBytes;
+  if( index_entries > 0)
+    f_write (&index_file, index_buffer, index_entries * sizeof( log_index_entry_t), &writtenBytes);
+  index_entries = 0;
+
+  // the log is preallocated, its directory entry does not tell where the data end
+  FSIZE_t index_size = f_tell( &index_file);
+  index_header.data_size = log_size;
+  f_lseek (&index_file, 0);
+  f_write (&index_file, &index_header, sizeof( index_header), &writtenBytes);
+  f_lseek (&index_file, index_size);
+  f_sync (&index_file);
+}
+
+//! create the index file <log filename>.IDX
+static void open_index_file( const char * filename)
+{
+  char buffer[50];
+  char *next = buffer;
+  next = append_string (next, filename);
+  next = append_string (next, ".IDX");
+  *next=0;
+
+  if( f_open (&index_file, buffer, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return; // log without index
+
+  UINT writtenBytes;
+  index_file_is_open = (f_write (&index_file, &index_header, sizeof( index_header), &writtenBytes) == FR_OK);
+}
+
+//! cut preallocated logs of flights ended by power-off to the size recorded in their index file
+static void truncate_interrupted_logs( void)
+{
+  DIR directory;
+  FILINFO info;
+  if( f_opendir (&directory, "") != FR_OK)
+    return;
+
+  while( (f_readdir (&directory, &info) == FR_OK) && (info.fname[0] != 0))
+    {
+      if( info.fsize != LOG_FILE_PREALLOCATION)
+	continue; // not preallocated, overflowed or cut already
+
+      char buffer[_MAX_LFN + 5];
+      char *next = buffer;
+      next = append_string (next, info.fname);
+      next = append_string (next, ".IDX");
+      *next=0;
+
+      // index_file is not in use yet, take it for both files
+      log_index_header_t header;
+      UINT bytesread;
+      if( f_open (&index_file, buffer, FA_READ) != FR_OK)
+	continue;
+      bool valid = (f_read (&index_file, &header, sizeof( header), &bytesread) == FR_OK)
+	  && (bytesread == sizeof( header)) && (header.magic == LOG_INDEX_MAGIC)
+	  && (header.version == LOG_INDEX_VERSION) && (header.data_size < info.fsize);
+      f_close (&index_file);
+
+      if( valid && (f_open (&index_file, info.fname, FA_WRITE) == FR_OK))
+	{
+	  if( f_lseek (&index_file, header.data_size) == FR_OK)
+	    f_truncate (&index_file);
+	  f_close (&index_file);
+	}
+    }
+  f_closedir (&directory);
+}
 
 extern uint32_t Bus_Fault_Address;
 extern uint8_t  Bus_Fault_Status;
@@ -54,36 +263,162 @@ inline char * newline( char * next)
   return next;
 }
 
+#define PLAYER_BLOCK_RECORDS 32 // 6400 bytes per f_read (), whole sectors go directly into the buffer
+static observations_type __ALIGNED(4) player_buffer[PLAYER_BLOCK_RECORDS];
+static log_quantization file_quantization( log_channels, log_channel_count); //!< compressed file being played
+
+// compressed files: block at the start of player_buffer, decoded record in the last slot
+static_assert( LOG_COMPRESSED_BLOCK_SIZE <= (PLAYER_BLOCK_RECORDS - 1) * sizeof( observations_type),
+	       "player buffer too small");
+static_assert( sizeof( observations_type) == LOG_RECORD_WORDS * sizeof( uint32_t),
+	       "compressed log format mismatch");
+
+//! reads flight records block-wise into player_buffer and hands them out without copying
 class flight_data_reader
   {
   public:
-    flight_data_reader( const char * filename)
-       : file_is_open(false)
+    flight_data_reader( const char * filename, bool compressed_format = false)
+       : file_is_open(false),
+	 compressed(false),
+	 decoder(file_quantization),
+	 next(player_buffer),
+	 end(player_buffer)
     {
-      FRESULT fresult;
-      fresult = f_open(&infile, filename, FA_READ);
-      if( fresult != FR_OK)
-        return;
-
-      file_is_open=true;
+      open( filename, compressed_format);
     }
 
-//! @return true if next record has been read
-  bool read_record( observations_type *target)
+//! @return true if the file could be opened
+  bool open( const char * filename, bool compressed_format)
   {
-    if( ! file_is_open)
+    close();
+    next = end = player_buffer;
+    compressed = compressed_format;
+
+    FRESULT fresult;
+    fresult = f_open(&infile, filename, FA_READ);
+    if( fresult != FR_OK)
       return false;
 
+    file_is_open=true;
+
+    // files with self-describing header: check layout and skip the header block
     UINT bytesread;
-    FRESULT fresult;
-    fresult = f_read(&infile, target, sizeof( observations_type), &bytesread);
-    if( (fresult != FR_OK) || (bytesread != sizeof( observations_type)))
+    fresult = f_read(&infile, player_buffer, LOG_HEADER_SIZE, &bytesread);
+    const log_header_t * header = 0;
+    if( (fresult == FR_OK) && (bytesread >= sizeof( log_header_t)))
+      header = get_log_header( player_buffer);
+    if( header && (sizeof( log_header_t) + header->channel_count * sizeof( log_channel_descriptor_t) > bytesread))
+      header = 0;
+
+    if( header)
       {
-	f_close( &infile);
+	if( (header->record_size != sizeof( observations_type))
+	    || (header->format != (compressed ? LOG_FORMAT_COMPRESSED : LOG_FORMAT_RAW)))
+	  {
+	    close(); // recorded by a firmware with different record layout
+	    return false;
+	  }
+	if( compressed) // decode with the quantization the file has been written with
+	  file_quantization.setup( get_log_channels( header), header->channel_count);
+	fresult = f_lseek(&infile, header->header_size);
+      }
+    else
+      fresult = f_lseek(&infile, 0); // legacy file
+
+    if( fresult != FR_OK)
+      {
+	close();
 	return false;
       }
     return true;
   }
+
+//! @return pointer to the next record within the block buffer or 0 if file exhausted
+  const observations_type * next_record( void)
+  {
+    if( compressed)
+      return next_compressed_record();
+
+    if( next >= end)
+      {
+	if( ! file_is_open)
+	  return 0;
+
+	UINT bytesread;
+	FRESULT fresult;
+	fresult = f_read(&infile, player_buffer, sizeof( player_buffer), &bytesread);
+	if( fresult != FR_OK)
+	  bytesread = 0;
+
+	next = player_buffer;
+	end  = player_buffer + bytesread / sizeof( observations_type); // ignore trailing fragment
+
+	if( bytesread < sizeof( player_buffer))
+	  close();
+
+	if( next >= end)
+	  return 0;
+      }
+    return next++;
+  }
+
+//! position the reader at the last index point at or before day_time_ms (GNSS time of day)
+//! @return false if no index is available, reader position unchanged then
+  bool seek( const char * index_filename, uint32_t day_time_ms)
+  {
+    if( ! file_is_open)
+      return false;
+
+    if( f_open(&index_file, index_filename, FA_READ) != FR_OK)
+      return false;
+
+    UINT bytesread;
+    log_index_header_t header;
+    uint32_t entries = 0;
+    if( (f_read(&index_file, &header, sizeof( header), &bytesread) == FR_OK) && (bytesread == sizeof( header))
+	&& (header.magic == LOG_INDEX_MAGIC) && (header.version == LOG_INDEX_VERSION)
+	&& (header.entry_size == sizeof( log_index_entry_t)))
+      entries = (f_size( &index_file) - sizeof( header)) / sizeof( log_index_entry_t);
+
+    // binary search for the last entry not later than day_time_ms
+    log_index_entry_t entry, found;
+    bool have_entry = false;
+    uint32_t low = 0, high = entries;
+    while( low < high)
+      {
+	uint32_t mid = (low + high) / 2;
+	if( (f_lseek(&index_file, sizeof( header) + mid * sizeof( log_index_entry_t)) != FR_OK)
+	    || (f_read(&index_file, &entry, sizeof( entry), &bytesread) != FR_OK)
+	    || (bytesread != sizeof( entry)))
+	  break;
+	if( entry.day_time_ms <= day_time_ms)
+	  {
+	    found = entry;
+	    have_entry = true;
+	    low = mid + 1;
+	  }
+	else
+	  high = mid;
+      }
+    f_close(&index_file);
+
+    if( ! have_entry || (f_lseek(&infile, found.offset) != FR_OK))
+      return false;
+
+    next = end = player_buffer;
+    decoder = log_block_decoder( file_quantization); // continue with a key frame
+    return true;
+  }
+
+//! @return true if next record has been read
+  bool read_record( observations_type *target)
+  {
+    const observations_type * record = next_record();
+    if( record == 0)
+      return false;
+    *target = *record;
+    return true;
+  }
   bool is_open( void)
   {
     return file_is_open;
@@ -92,13 +427,38 @@ class flight_data_reader
   {
     if( file_is_open)
       {
-	FRESULT fresult;
-	fresult = f_close( &infile);
+	f_close( &infile);
+	file_is_open = false;
       }
   }
 private:
+  const observations_type * next_compressed_record( void)
+  {
+    observations_type * record = player_buffer + PLAYER_BLOCK_RECORDS - 1;
+    while( ! decoder.decode( (uint32_t *)record))
+      {
+	if( ! file_is_open)
+	  return 0;
+
+	UINT bytesread;
+	FRESULT fresult;
+	fresult = f_read(&infile, player_buffer, LOG_COMPRESSED_BLOCK_SIZE, &bytesread);
+	if( (fresult != FR_OK) || (bytesread < LOG_COMPRESSED_BLOCK_SIZE)
+	    || ! decoder.start( (const uint8_t *)player_buffer))
+	  {
+	    close();
+	    return 0;
+	  }
+      }
+    return record;
+  }
+
   FIL infile;
   bool file_is_open;
+  bool compressed; //!< .c50 format
+  log_block_decoder decoder;
+  const observations_type * next; //!< next record to be delivered
+  const observations_type * end;  //!< behind last valid record within the block buffer
 };
 
 void write_crash_dump( void)
@@ -203,7 +563,7 @@ void write_EEPROM_dump( const char * filename)
 	      *next++=' ';
 	      next = append_string( next, PERSISTENT_DATA[index].mnemonic);
 	      next = append_string (next," = ");
-	      next = my_ftoa (next, value);
+	      next = my_ftoa (next, value); // parameters of any magnitude, kept as the existing dump readers expect
 	      *next++='\r';
 	      *next++='\n';
 	      *next=0;
@@ -219,6 +579,98 @@ void write_EEPROM_dump( const char * filename)
   f_close(&fp);
 }
 
+//! write the self-describing header block, the records follow at LOG_HEADER_SIZE
+static bool write_log_header( FIL & file)
+{
+  static_assert( LOG_HEADER_SIZE == LOG_BLOCK_SIZE, "records shall stay block-aligned");
+  ASSERT( ! log_ring_state.active); // ring is used as scratch buffer
+
+  uint8_t * block = log_ring;
+  memset( block, 0, LOG_HEADER_SIZE);
+
+  log_header_t * header = (log_header_t *)block;
+  header->magic = LOG_HEADER_MAGIC;
+  header->version = LOG_HEADER_VERSION;
+  header->header_size = LOG_HEADER_SIZE;
+  header->record_size = RECORD_SIZE;
+  header->sample_rate = LOG_SAMPLE_RATE;
+  header->format = LOG_COMPRESSION ? LOG_FORMAT_COMPRESSED : LOG_FORMAT_RAW;
+  header->channel_count = log_channel_count;
+  memcpy( header->unique_id, UNIQUE_ID, sizeof( header->unique_id));
+  strncpy( header->firmware, GIT_TAG_INFO, LOG_FIRMWARE_LENGTH - 1);
+
+  ASSERT( sizeof( log_header_t) + log_channel_count * sizeof( log_channel_descriptor_t) < LOG_HEADER_SIZE);
+  memcpy( (void *)get_log_channels( header), log_channels, log_channel_count * sizeof( log_channel_descriptor_t));
+
+  // persistent data snapshot, as much as fits into the block
+  log_parameter_t * parameter = (log_parameter_t *)get_log_parameters( header);
+  for( unsigned index = 1; index < PERSISTENT_DATA_ENTRIES; ++index)
+    {
+      if( ((uint8_t *)(parameter + 1) > block + LOG_HEADER_SIZE) || (header->parameter_count == UINT8_MAX))
+	{
+	  header->flags |= LOG_PARAMETERS_TRUNCATED; // complete set in the .EEPROM file
+	  break;
+	}
+      float value;
+      if( read_EEPROM_value( PERSISTENT_DATA[index].id, value) != HAL_OK)
+	continue;
+      parameter->id = PERSISTENT_DATA[index].id;
+      strncpy( parameter->mnemonic, PERSISTENT_DATA[index].mnemonic, sizeof( parameter->mnemonic) - 1);
+      parameter->value = value;
+      ++parameter;
+      ++header->parameter_count;
+    }
+
+  UINT writtenBytes;
+  FRESULT fresult = f_write (&file, block, LOG_HEADER_SIZE, &writtenBytes);
+  return (fresult == FR_OK) && (writtenBytes == LOG_HEADER_SIZE);
+}
+
+#if MEASURE_STAGE_TIMING
+
+//! append execution time statistics of the 100 Hz loop to <log filename>.TIM
+static void write_timing_report( const char * filename)
+{
+  FIL fp;
+  char buffer[(TIMING_HISTOGRAM_BINS + 5) * 11 + 80]; // worst case report line
+  char *next = buffer;
+  UINT writtenBytes;
+
+  next = append_string (next, filename);
+  next = append_string (next, ".TIM");
+  *next=0;
+
+  if( f_open (&fp, buffer, FA_OPEN_APPEND | FA_WRITE) != FR_OK)
+    return; // silently give up
+
+  for( unsigned i = 0; i < TIMING_REPORT_LINES; ++i)
+    {
+      next = format_timing_report_line( buffer, i);
+      next = newline( next);
+      if( f_write (&fp, buffer, next - buffer, &writtenBytes) != FR_OK)
+	break;
+    }
+
+  // board health, all ADC channels are evaluated here only
+  ADC_readings_t ADC_readings;
+  ADC_get_readings( ADC_readings);
+  next = append_string( buffer, "ADC supply ");
+  next = format_fixed<2>( next, ADC_readings.supply_voltage);
+  next = append_string( next, " V VDDA ");
+  next = format_fixed<3>( next, ADC_readings.VDDA);
+  next = append_string( next, " V CPU ");
+  next = format_fixed<1>( next, ADC_readings.CPU_temperature);
+  next = append_string( next, " C");
+  next = newline( next);
+  f_write (&fp, buffer, next - buffer, &writtenBytes);
+
+  next = newline( buffer);
+  f_write (&fp, buffer, next - buffer, &writtenBytes);
+  f_close(&fp);
+}
+
+#endif
+
 void write_magnetic_calibration_file (const coordinates_t &c)
 {
   FRESULT fresult;
@@ -250,6 +702,7 @@ void write_magnetic_calibration_file (const coordinates_t &c)
   for( unsigned i=0; i<3; ++i)
     {
       char *next = buffer;
+      // my_ftoa (): the variances are far below 1e-6, format_fixed<> would flush them to zero
       next = my_ftoa (next, data[i].y_offset);
       *next++='\t';
       next = my_ftoa (next, data[i].slope);
@@ -291,19 +744,52 @@ data_logger_runnable (void*)
     }
 
   ASSERT( sizeof( observations_type) == 50 * sizeof(float));
+
+  truncate_interrupted_logs();
+
+  const char * index_filename = "flight_data.f50.IDX";
   flight_data_reader input_reader( "flight_data.f50");
+  if( ! input_reader.is_open())
+    {
+      input_reader.open( "flight_data.h50", false);
+      index_filename = "flight_data.h50.IDX";
+    }
+  if( ! input_reader.is_open())
+    {
+      input_reader.open( "flight_data.c50", true);
+      index_filename = "flight_data.c50.IDX";
+    }
   if( input_reader.is_open())
     {
+#if PLAYER_START_TIME
+      input_reader.seek( index_filename, PLAYER_START_TIME * 1000);
+#else
+      (void)index_filename;
+#endif
       read_configuration_file( (char *)"flight_data.EEPROM", true); // read configuration dump file if it is present on the SD card
 
       replaying_data = true;
       // fake system state = "basic sensors operative"
       system_state = GNSS_AVAILABLE | MTI_SENSOR_AVAILABE | MS5611_STATIC_AVAILABLE | PITOT_SENSOR_AVAILABLE;
 
-      while( input_reader.read_record( (observations_type *)&output_data))
+      SD_card_to_communicator_synchronizer.signal(); // configuration is complete
+
+#if PLAYER_REAL_TIME
+      synchronous_timer pace( 10); // 100 Hz
+#endif
+      while( true)
 	{
+		output_data_lock.write_begin(); // player and communicator take turns as writer
+		bool record_read = input_reader.read_record( (observations_type *)&output_data);
+		output_data_lock.write_end();
+		if( ! record_read)
+		  break;
+
 		SD_card_to_communicator_synchronizer.signal();
-		delay(10);
+		notify_take (true); // wait until the communicator has digested this record
+#if PLAYER_REAL_TIME
+		pace.sync();
+#endif
 	}
 
       input_reader.close();
@@ -374,7 +860,7 @@ data_logger_runnable (void*)
     idx++;
 
   out_filename[idx] = '.';
-  out_filename[idx + 1] = 'f';
+  out_filename[idx + 1] = LOG_COMPRESSION ? 'c' : 'h'; // legacy readers expect *.f50 without header
 
   itoa ((sizeof(coordinates_t) + sizeof(measurement_data_t)) / sizeof(float),
 	out_filename + idx + 2, 10);
@@ -382,7 +868,6 @@ data_logger_runnable (void*)
   GPIO_PinState led_state = GPIO_PIN_RESET;
 
   uint32_t writtenBytes = 0;
-  uint8_t *buf_ptr = buffer;
 
   write_EEPROM_dump( out_filename);
 
@@ -390,41 +875,76 @@ data_logger_runnable (void*)
   if (fresult != FR_OK)
     suspend (); // give up, logger unable to work
 
+  open_index_file( out_filename); // allocates its first cluster outside the log area
+
+  // link a contiguous cluster chain for the log: f_write () only follows it, no FAT update on the
+  // write path, and side files written later can not interrupt it.
+  // The directory entry keeps the preallocated size, the synchronized size goes into the index file
+  // and truncate_interrupted_logs () cuts the file to it at the next start.
+  (void)f_expand (&outfile, LOG_FILE_PREALLOCATION, 1); // failing: card too fragmented, the file grows cluster by cluster
+
+  if( ! write_log_header( outfile))
+    suspend (); // give up, logger unable to work
+
   int32_t sync_counter=0;
+#if MEASURE_STAGE_TIMING
+  uint64_t last_timing_report = getTime_usec();
+#endif
+
+  ring_origin = log_ring_state.read_index = log_ring_state.write_index;
+  log_ring_state.active = true; // from now on the communicator fills the ring
 
   while( true) // logger loop synchronized by communicator
     {
-      notify_take (true); // wait for synchronization by from communicator
+      notify_take (true); // wait until the communicator has completed a block
 
       if( crashfile)
 	write_crash_dump();
 
-      memcpy (buf_ptr, (uint8_t*) &output_data.m, sizeof(measurement_data_t)+sizeof(coordinates_t));
-      buf_ptr += sizeof(measurement_data_t)+sizeof(coordinates_t);
-
-      if (buf_ptr < buffer + BUFSIZE)
-	continue; // buffer only filled partially
-
-      fresult = f_write (&outfile, buffer, BUFSIZE, (UINT*) &writtenBytes);
-      if( ! ((fresult == FR_OK) && (writtenBytes == BUFSIZE)))
-	while(true)
-	  suspend (); // give up, logger can not work
-
-      uint32_t rest = buf_ptr - (buffer + BUFSIZE);
-      memcpy (buffer, buffer + BUFSIZE, rest);
-      buf_ptr = buffer + rest;
-
-      if( ++sync_counter >= 16)
+      const uint8_t * block;
+      while( (block = next_log_block()) != 0)
 	{
-	  f_sync (&outfile);
-	  sync_counter = 0;
+	  uint64_t start_time = getTime_usec();
+
+	  FSIZE_t block_offset = outfile.fptr;
+	  fresult = f_write (&outfile, block, LOG_BLOCK_SIZE, (UINT*) &writtenBytes);
+	  if( ! ((fresult == FR_OK) && (writtenBytes == LOG_BLOCK_SIZE)))
+	    while(true)
+	      suspend (); // give up, logger can not work
+
+	  add_index_entry( block_offset);
+	  release_log_block();
+
+	  bool sync_due = ++sync_counter >= 16;
+	  if( sync_due)
+	    {
+	      f_sync (&outfile);
+	      flush_index( outfile.fptr);
+	      sync_counter = 0;
+	    }
+
+	  // the ring must cover the worst case including the periodic FAT / directory / index update
+	  uint32_t latency = (uint32_t)(getTime_usec() - start_time);
+	  if( latency > log_ring_state.max_write_latency_us)
+	    log_ring_state.max_write_latency_us = latency;
+
+	  if( sync_due)
+	    {
+#if MEASURE_STAGE_TIMING
+	      if( start_time - last_timing_report > TIMING_REPORT_INTERVAL_USEC)
+		{
+		  last_timing_report = start_time;
+		  write_timing_report( out_filename);
+		}
+#endif
 #if uSD_LED_STATUS
-	  HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, led_state);
-	  led_state = led_state == GPIO_PIN_RESET ? GPIO_PIN_SET : GPIO_PIN_RESET;
+	      HAL_GPIO_WritePin (LED_STATUS1_GPIO_Port, LED_STATUS2_Pin, led_state);
+	      led_state = led_state == GPIO_PIN_RESET ? GPIO_PIN_SET : GPIO_PIN_RESET;
 #endif
 #if LOG_MAGNETIC_CALIBRATION
-	  write_magnetic_calibration_file ( output_data.c);
+	      write_magnetic_calibration_file ( output_data.c);
 #endif
+	    }
 	}
     }
 }
@@ -443,9 +963,34 @@ static TaskParameters_t p =
 
 COMMON RestrictedTask data_logger (p);
 
-extern "C" void sync_logger(void)
+extern "C" void sync_logger(void) // runs within the communicator task
   {
-    data_logger.notify_give ();
+    if( ! log_ring_state.active) // no output file (yet) or player running
+      {
+	data_logger.notify_give ();
+	return;
+      }
+
+    uint32_t write_index = log_ring_state.write_index;
+    if( write_index - log_ring_state.read_index > LOG_RING_SIZE - RECORD_SIZE)
+      {
+	++log_ring_state.dropped_records; // SD card too slow, logger is lagging
+	return;
+      }
+
+    uint32_t offset = write_index % LOG_RING_SIZE;
+    uint32_t first_part = LOG_RING_SIZE - offset;
+    if( first_part > RECORD_SIZE)
+      first_part = RECORD_SIZE;
+
+    memcpy( log_ring + offset, (uint8_t*) &output_data.m, first_part);
+    memcpy( log_ring, (uint8_t*) &output_data.m + first_part, RECORD_SIZE - first_part); // wrap around
+
+    __DMB(); // data before index
+    log_ring_state.write_index = write_index + RECORD_SIZE;
+
+    if( (write_index % LOG_BLOCK_SIZE) + RECORD_SIZE >= LOG_BLOCK_SIZE)
+      data_logger.notify_give (); // a block has been completed
   }
 
 extern "C" void emergency_write_crashdump( char * file, int line, uint64_t data)
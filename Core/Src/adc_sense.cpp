@@ -1,47 +1,121 @@
+/** ***********************************************************************
+ * @file		adc_sense.cpp
+ * @brief		timer triggered ADC1 scan into a circular DMA buffer
+ **************************************************************************/
+
+#include "system_configuration.h"
+#include "main.h"
 #include "FreeRTOS_wrapper.h"
-#include "ascii_support.h"
 #include "stm32f4xx_hal.h"
-#include "communicator.h"
+#include "my_assert.h"
+#include "adc_sense.h"
 
 extern ADC_HandleTypeDef hadc1;
+COMMON DMA_HandleTypeDef hdma_adc1;
+COMMON TIM_HandleTypeDef htim2;
+
+enum { SUPPLY, TEMPERATURE, VREFINT, ADC_CHANNELS}; // scan order, see MX_ADC1_Init
+
+// factory calibration, measured at VDDA = 3.3 V
+#define VREFINT_CAL_ADDRESS	((const uint16_t *)0x1FFF7A2A)
+#define TS_CAL1_ADDRESS		((const uint16_t *)0x1FFF7A2C) // 30 degrees
+#define TS_CAL2_ADDRESS		((const uint16_t *)0x1FFF7A2E) // 110 degrees
+#define CALIBRATION_VDDA	3.3f
+#define SUPPLY_DIVIDER		11.0f
+#define ADC_FULL_SCALE		4095.0f
+
+COMMON static uint16_t ADC_samples[ADC_AVERAGING][ADC_CHANNELS];
+//! copies of the calibration values: system memory is not accessible for unprivileged tasks
+COMMON static uint16_t VREFINT_CAL;
+COMMON static uint16_t TS_CAL1;
+COMMON static uint16_t TS_CAL2;
+
+void ADC_start_scan( void)
+{
+  VREFINT_CAL = *VREFINT_CAL_ADDRESS;
+  TS_CAL1 = *TS_CAL1_ADDRESS;
+  TS_CAL2 = *TS_CAL2_ADDRESS;
+
+  // no DMA interrupt: the ring is just overwritten
+  hdma_adc1.Instance = DMA2_Stream4;
+  hdma_adc1.Init.Channel = DMA_CHANNEL_0;
+  hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  hdma_adc1.Init.Mode = DMA_CIRCULAR;
+  hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+  hdma_adc1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init (&hdma_adc1) != HAL_OK)
+    {
+      ASSERT(0);
+    }
+  __HAL_LINKDMA(&hadc1, DMA_Handle, hdma_adc1);
+
+  // TIM2 @ 84 MHz -> 1 MHz counter clock, update event as ADC trigger
+  __HAL_RCC_TIM2_CLK_ENABLE();
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 84 - 1;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 1000000 / ADC_SCAN_RATE_HZ - 1;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init (&htim2) != HAL_OK)
+    {
+      ASSERT(0);
+    }
 
-#define ITM_TRACE 0
+  TIM_MasterConfigTypeDef master_config = { 0 };
+  master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization (&htim2, &master_config) != HAL_OK)
+    {
+      ASSERT(0);
+    }
 
-#define CONVERSION_FACTOR  (11.0f * 3.3f / 4096.0f)
-float get_supply_voltage(void)
+  if (HAL_ADC_Start_DMA (&hadc1, (uint32_t *)ADC_samples, ADC_AVERAGING * ADC_CHANNELS) != HAL_OK)
+    {
+      ASSERT(0);
+    }
+  HAL_TIM_Base_Start (&htim2);
+}
+
+// DMA writes are atomic per sample, mixing two scans is harmless for the average
+static uint32_t channel_sum( unsigned channel)
+{
+  uint32_t sum = 0;
+  for( unsigned scan = 0; scan < ADC_AVERAGING; ++scan)
+    sum += ADC_samples[scan][channel];
+  return sum;
+}
+
+//! VREFINT_CAL / Vrefint reading = VDDA / 3.3 V, fall back to nominal without calibration
+static float VDDA_ratio( uint32_t Vrefint_sum)
 {
-	uint32_t  value = 0;
-	HAL_ADC_Start(&hadc1);
-	while(HAL_OK != HAL_ADC_PollForConversion(&hadc1, 0))
-	{
-		delay(10);  //TODO: implement interrupt notification.
-	}
-	value = HAL_ADC_GetValue(&hadc1);
-	return (float)value * CONVERSION_FACTOR;
+  if( Vrefint_sum != 0 && VREFINT_CAL != 0 && VREFINT_CAL != 0xffff)
+    return (float)VREFINT_CAL * ADC_AVERAGING / (float)Vrefint_sum;
+  return 1.0f;
 }
 
-#if ITM_TRACE
-COMMON char buf[10];
-#endif
-void adc_measurement(void*)
+float ADC_get_supply_voltage( void)
 {
-	for(;;)
-	{
-		output_data.m.supply_voltage = get_supply_voltage();
-		delay(100);
-
-#if ITM_TRACE
-		itoa((uint32_t)(output_data.m.supply_voltage*1000.0), buf);
-		uint32_t idx = 0;
-		while(buf[idx] != 0)
-		{
-			ITM_SendChar(buf[idx]);
-			idx++;
-		}
-		ITM_SendChar('\r');
-		ITM_SendChar('\n');
-#endif
-	}
+  return (float)channel_sum( SUPPLY) * (1.0f / ADC_AVERAGING)
+      * CALIBRATION_VDDA * VDDA_ratio( channel_sum( VREFINT)) * ( SUPPLY_DIVIDER / ADC_FULL_SCALE);
 }
 
-RestrictedTask adc_reading(adc_measurement, "ADC_READ", 128);
+void ADC_get_readings( ADC_readings_t & readings)
+{
+  float ratio = VDDA_ratio( channel_sum( VREFINT));
+  readings.VDDA = CALIBRATION_VDDA * ratio;
+  readings.supply_voltage = ADC_get_supply_voltage();
+
+  // temperature reading as if taken at the calibration VDDA
+  float temperature_reading = (float)channel_sum( TEMPERATURE) * (1.0f / ADC_AVERAGING) * ratio;
+  if( TS_CAL2 > TS_CAL1 && TS_CAL2 != 0xffff)
+    readings.CPU_temperature = 30.0f
+	+ (temperature_reading - (float)TS_CAL1) * (80.0f / (float)( TS_CAL2 - TS_CAL1));
+  else // data sheet typical: 0.76 V @ 25 degrees, 2.5 mV / degree
+    readings.CPU_temperature = 25.0f
+	+ (temperature_reading * ( CALIBRATION_VDDA / ADC_FULL_SCALE) - 0.76f) * (1.0f / 0.0025f);
+}
@@ -0,0 +1,145 @@
+/** ***********************************************************************
+ * @file		fixed_point_format.cpp
+ * @brief		fast decimal text output, NMEA sentences with running checksum
+ **************************************************************************/
+
+#include "fixed_point_format.h"
+
+static const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+char * format_unsigned( char * next, uint32_t value, unsigned min_digits)
+{
+  char digits[10];
+  char * p = digits + sizeof( digits); // filled from the end
+  while( value >= 100)
+    {
+      unsigned pair = value % 100;
+      value /= 100;
+      p -= 2;
+      p[0] = digit_pairs[2 * pair];
+      p[1] = digit_pairs[2 * pair + 1];
+    }
+  if( value >= 10)
+    {
+      p -= 2;
+      p[0] = digit_pairs[2 * value];
+      p[1] = digit_pairs[2 * value + 1];
+    }
+  else
+    *--p = (char)('0' + value);
+
+  for( unsigned n = digits + sizeof( digits) - p; n < min_digits; ++n)
+    *next++ = '0';
+  while( p < digits + sizeof( digits))
+    *next++ = *p++;
+  return next;
+}
+
+char * format_signed( char * next, int32_t value, unsigned min_digits)
+{
+  if( value < 0)
+    {
+      *next++ = '-';
+      return format_unsigned( next, 0U - (uint32_t)value, min_digits);
+    }
+  return format_unsigned( next, (uint32_t)value, min_digits);
+}
+
+char * format_hex( char * next, uint32_t value, unsigned digits)
+{
+  for( unsigned i = digits; i > 0; --i)
+    *next++ = hex_digits[(value >> (4 * (i - 1))) & 0x0f];
+  return next;
+}
+
+static char * append( char * next, const char * text)
+{
+  while( *text)
+    *next++ = *text++;
+  return next;
+}
+
+int64_t scale_float( char * & next, float value, uint32_t factor)
+{
+  union { float f; uint32_t u; } x;
+  x.f = value;
+
+  bool negative = x.u >> 31;
+  int exponent = (x.u >> 23) & 0xff;
+  uint32_t mantissa = x.u & 0x7fffff;
+
+  if( negative)
+    *next++ = '-';
+
+  if( exponent == 0xff)
+    {
+      next = append( next, mantissa ? "nan" : "inf");
+      return -1;
+    }
+
+  if( exponent == 0)
+    exponent = -149; // denormal
+  else
+    {
+      mantissa |= 1 << 23;
+      exponent -= 150;
+    }
+
+  // value = mantissa * 2^exponent, scaled = mantissa * factor * 2^exponent exactly
+  uint64_t product = (uint64_t)mantissa * factor; // < 2^44
+  if( exponent >= 0)
+    {
+      if( exponent > 18 || (product << exponent) >> exponent != product)
+	{
+	  next = append( next, "ovf");
+	  return -1;
+	}
+      return (int64_t)(product << exponent);
+    }
+
+  unsigned shift = -exponent;
+  if( shift > 45)
+    return 0; // < 0.5
+
+  uint64_t result = product >> shift;
+  uint64_t remainder = product & ((1ULL << shift) - 1);
+  uint64_t half = 1ULL << (shift - 1);
+  if( remainder > half || (remainder == half && (result & 1))) // round half to even
+    ++result;
+  return (int64_t)result;
+}
+
+NMEA_sentence::NMEA_sentence( char * buffer, const char * header)
+  : next( buffer), checksummed( buffer + 1), checksum( 0)
+{
+  *next++ = '$';
+  add( append( next, header));
+}
+
+NMEA_sentence & NMEA_sentence::text( const char * text)
+{
+  *next++ = ',';
+  return add( append( next, text));
+}
+
+char * NMEA_sentence::finish( void)
+{
+  *next++ = '*';
+  next = format_hex( next, checksum, 2);
+  *next++ = '\r';
+  *next++ = '\n';
+  *next = 0;
+  return next;
+}
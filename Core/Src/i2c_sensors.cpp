@@ -0,0 +1,235 @@
+/**
+ @file i2c_sensors.cpp
+ @brief one task for all I2C sensors: MS5611 pair, HCLA pitot sensor, FXOS8700
+ @author: Klaus Schaefer, Maximilian Betz
+
+ All transfers of one cycle are queued at the same instant and run
+ interrupt driven on both buses in parallel, ordered by device priority.
+ A cycle starts on the IMU tick, together with the communicator cycle, see
+ sync_communicator(). Its 10 ms period covers the 9.04 ms MS5611 conversion,
+ a cycle coming too early (jitter, own timeout) skips the MS5611 transfers.
+ Devices are initialized with the blocking I2C functions.
+ Host check: Host_tools/I2C_timing_check.cpp
+ */
+#include "system_configuration.h"
+#include "main.h"
+#include "FreeRTOS_wrapper.h"
+#include "i2c.h"
+#include "I2C_scheduler.h"
+#include "common.h"
+#include "communicator.h"
+#include "ms5611.h"
+#include "fxos8700cq.h"
+#if PRESSURE_PREFILTER
+#include "pressure_prefilter.h"
+#endif
+
+#if RUN_MS5611_MODULE || RUN_PITOT_MODULE || RUN_FXOS8700
+
+#define I2C_SENSORS_TIMEOUT_MS	20 // no IMU tick (IMU restart, player): run on our own
+
+#define HCLA_I2C_ADDRESS (0x28<<1) // 7 bits left-adjusted
+#define HCLA_I2C_SCHEDULER I2C1_scheduler
+/*
+ * Bereich: 80% von 16384 counts auf 1PSI verteilt
+ * ergibt 6895 Pa / 13107 counts = 0.5261 Pa / count
+ */
+#define SPAN 0.5261f
+#define OFFSET 1638 // exakt 0.1 * 16384
+
+#define FXOS8700_SCHEDULER I2C1_scheduler
+
+static void runnable( void *)
+{
+  I2C_Init( &hi2c1);
+  I2C_Init( &hi2c2);
+
+#if RUN_PITOT_MODULE
+  I2C_device_t HCLA( HCLA_I2C_ADDRESS, 0);
+  uint8_t HCLA_data[2];
+  I2C_transaction_t HCLA_read = { &HCLA, I2C_TRANSFER_READ, 0, HCLA_data, 2, I2C_ERROR};
+#endif
+#if RUN_FXOS8700
+  I2C_device_t FXOS8700( FXOS8700_I2C_ADDR, 1);
+  uint8_t FXOS8700_data[FXOS8700_DATA_SIZE];
+  I2C_transaction_t FXOS8700_read =
+      { &FXOS8700, I2C_TRANSFER_READ_REGISTER, FXOS8700_REGISTER_STATUS, FXOS8700_data, FXOS8700_DATA_SIZE, I2C_ERROR};
+#endif
+
+  while (true) // re-initialization loop
+    {
+      HCLA_I2C_SCHEDULER.disable();
+      MS5611_SCHEDULER.disable();
+
+#if RUN_MS5611_MODULE
+      update_system_state_clear(MS5611_STATIC_AVAILABLE);
+      update_system_state_clear(MS5611_PITOT_AVAILABLE);
+
+      delay (2);
+
+      MS5611 ms5611_static (0xEE, 0); // vario first
+      MS5611 ms5611_pitot (0xEC, 1);  // Second ms5611 sensor on PCB.
+
+      bool static_ms5611_available = ms5611_static.initialize ();
+      if (static_ms5611_available)
+	update_system_state_set (MS5611_STATIC_AVAILABLE);
+
+      bool pitot_ms5611_available = ms5611_pitot.initialize ();
+      if (pitot_ms5611_available)
+	update_system_state_set (MS5611_PITOT_AVAILABLE);
+
+      pressure_sample_t sample = { 0 };
+#if PRESSURE_PREFILTER
+      // group delay (PRESSURE_MEDIAN_LENGTH - 1) / 2 + PRESSURE_BIQUAD_DELAY conversions
+      pressure_prefilter static_filter;
+      pressure_prefilter pitot_filter; // same delay on both sides of the pitot difference
+#endif
+#endif
+
+#if RUN_FXOS8700
+      bool fxos8700_available = false;
+      for( unsigned retries = 10; retries > 0; --retries)
+	{
+	  fxos8700_available = FXOS8700_Initialize(ACCEL_RANGE_4G);
+	  if (true == fxos8700_available)
+	    {
+	      update_system_state_set( FXOS_SENSOR_AVAILABLE);
+	      break;
+	    }
+	}
+#endif
+#if RUN_PITOT_MODULE
+      bool HCLA_available = I2C_OK == I2C_Read( &hi2c1, HCLA_I2C_ADDRESS, HCLA_data, 2);
+      if( HCLA_available)
+	update_system_state_set( PITOT_SENSOR_AVAILABLE);
+
+      delay( 10); // wait for "next measurement available"
+#endif
+
+      HCLA_I2C_SCHEDULER.enable();
+      MS5611_SCHEDULER.enable();
+
+      bool reinitialize = false;
+#if RUN_MS5611_MODULE
+      uint64_t conversion_start = getTime_usec_privileged();
+#endif
+      while( ! reinitialize)
+	{
+	  notify_take( true, I2C_SENSORS_TIMEOUT_MS); // IMU tick @ 100 Hz
+#if RUN_MS5611_MODULE
+	  uint64_t batch_start = getTime_usec_privileged(); // this batch starts the next conversion
+	  // reading an unfinished conversion returns 0 and restarts it
+	  bool conversion_ready = batch_start - conversion_start >= MS5611_CONVERSION_TIME_USEC + MS5611_TRANSFER_TIME_USEC;
+#endif
+	  I2C1_scheduler.clear();
+	  I2C2_scheduler.clear();
+
+#if RUN_MS5611_MODULE
+	  // both MS5611 convert in parallel, one conversion per period, mostly pressure
+	  if( static_ms5611_available && conversion_ready)
+	    ms5611_static.schedule( MS5611_SCHEDULER);
+	  if( pitot_ms5611_available && conversion_ready)
+	    ms5611_pitot.schedule( MS5611_SCHEDULER);
+#endif
+#if RUN_PITOT_MODULE
+	  if( HCLA_available)
+	    HCLA_I2C_SCHEDULER.add( HCLA_read);
+#endif
+#if RUN_FXOS8700
+	  if( fxos8700_available)
+	    FXOS8700_SCHEDULER.add( FXOS8700_read);
+#endif
+
+	  I2C1_scheduler.start();
+	  I2C2_scheduler.start();
+	  I2C1_scheduler.finish();
+	  I2C2_scheduler.finish();
+
+#if RUN_MS5611_MODULE
+	  /* Every 10th conversion is a temperature conversion: pressure comes
+	   * 9 times in 100 ms with one 20 ms gap. The pre-filters are fed the
+	   * held pressure in the gap, they keep a uniform 10 ms time base.
+	   * An early cycle without MS5611 transfers is treated like the gap.
+	   */
+	  bool updated = false;
+
+	  if( ! conversion_ready)
+	    {
+#if PRESSURE_PREFILTER
+	      static_filter.hold();
+	      pitot_filter.hold();
+#endif
+	    }
+	  else
+	    {
+	      if ( static_ms5611_available)
+		{
+		  if( ms5611_static.evaluate () == false)
+		    reinitialize = true;
+		  else if( ms5611_static.pressure_updated())
+		    {
+#if PRESSURE_PREFILTER
+		      sample.static_pressure = static_filter.feed( ms5611_static.get_pressure ());
+#else
+		      sample.static_pressure = ms5611_static.get_pressure ();
+#endif
+		      sample.static_sensor_temperature =
+			  ms5611_static.get_temperature ();
+		      updated = true;
+		    }
+#if PRESSURE_PREFILTER
+		  else
+		    static_filter.hold(); // temperature conversion
+#endif
+		}
+
+	      if ( pitot_ms5611_available)
+		{
+		  if( ms5611_pitot.evaluate () == false)
+		    reinitialize = true;
+		  else if( ms5611_pitot.pressure_updated())
+		    {
+#if PRESSURE_PREFILTER
+		      sample.absolute_pressure = pitot_filter.feed( ms5611_pitot.get_pressure ());
+#else
+		      sample.absolute_pressure = ms5611_pitot.get_pressure ();
+#endif
+		      sample.absolute_sensor_temperature =
+			  ms5611_pitot.get_temperature ();
+		      updated = true;
+		    }
+#if PRESSURE_PREFILTER
+		  else
+		    pitot_filter.hold();
+#endif
+		}
+
+	      if( updated)
+		pressure_slot.publish( sample);
+	      conversion_start = batch_start;
+	    }
+#endif
+#if RUN_PITOT_MODULE
+	  // status bits != 0: stale data or diagnostic condition, skip the sample
+	  if( HCLA_available && HCLA_read.status == I2C_OK && ( HCLA_data[0] & 0xC0) == 0)
+	    {
+	      uint16_t raw_data = (HCLA_data[0] << 8) | HCLA_data[1];
+	      pitot_slot.publish( (float)( raw_data - OFFSET) * SPAN);
+	    }
+#endif
+#if RUN_FXOS8700
+	  if( fxos8700_available && FXOS8700_read.status == I2C_OK)
+	    {
+	      lowcost_acc_mag_sample_t acc_mag;
+	      FXOS8700_decode( FXOS8700_data, acc_mag.acc, acc_mag.mag);
+	      lowcost_acc_mag_slot.publish( acc_mag);
+	    }
+#endif
+	}
+    }
+}
+
+// privileged: bus recovery reconfigures the GPIO pins
+RestrictedTask i2c_sensors ( runnable, "I2C", 512, 0, I2C_SENSORS_PRIORITY + portPRIVILEGE_BIT);
+
+#endif
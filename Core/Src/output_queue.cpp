@@ -0,0 +1,94 @@
+/** ***********************************************************************
+ * @file		output_queue.cpp
+ * @brief		byte queue feeding one asynchronous output channel
+ **************************************************************************/
+
+#include "output_queue.h"
+#include "FreeRTOS_wrapper.h"
+
+void output_queue::write( const char * data, unsigned length)
+{
+  taskENTER_CRITICAL();
+  if( length > size - (write_count - read_count))
+    {
+      ++overflows;
+
+      // keep what is in transfer plus the rest of its last sentence
+      uint32_t keep = read_count + in_flight;
+      while( keep != write_count && buffer[(keep - 1) % size] != '\n')
+	++keep;
+
+      if( policy == DROP_OLDEST && length <= size - (keep - read_count))
+	{
+	  dropped_bytes += write_count - keep;
+	  write_count = keep;
+	}
+      else
+	{
+	  dropped_bytes += length;
+	  taskEXIT_CRITICAL();
+	  return;
+	}
+    }
+  taskEXIT_CRITICAL();
+
+  // the free part of the queue belongs to the producer, no locking needed
+  unsigned position = write_count % size;
+  for( unsigned i = 0; i < length; ++i)
+    {
+      buffer[position] = data[i];
+      if( ++position >= size)
+	position = 0;
+    }
+
+  taskENTER_CRITICAL();
+  write_count = write_count + length;
+  if( in_flight == 0)
+    start_next();
+  taskEXIT_CRITICAL();
+}
+
+void output_queue::on_transfer_complete( void)
+{
+  read_count = read_count + in_flight;
+  in_flight = 0;
+  start_next();
+}
+
+void output_queue::recover( bool channel_idle)
+{
+  if( ! channel_idle)
+    return;
+
+  taskENTER_CRITICAL();
+  if( in_flight != 0) // no transfer running, its completion has been lost
+    {
+      ++lost_transfers;
+      dropped_bytes += in_flight;
+      read_count = read_count + in_flight;
+      in_flight = 0;
+      start_next();
+    }
+  taskEXIT_CRITICAL();
+}
+
+void output_queue::start_next( void)
+{
+  uint32_t queued = write_count - read_count;
+  if( queued == 0)
+    return;
+
+  // one contiguous piece, the wrapped part follows with the next transfer
+  unsigned position = read_count % size;
+  if( queued > size - position)
+    queued = size - position;
+  if( queued > 0xffff)
+    queued = 0xffff;
+
+  in_flight = queued;
+  if( ! start_transfer( buffer + position, (uint16_t)queued))
+    {
+      in_flight = 0;
+      ++refused_transfers;
+    }
+}
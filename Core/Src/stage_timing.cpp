@@ -0,0 +1,153 @@
+/** ***********************************************************************
+ * @file		stage_timing.cpp
+ * @brief		execution time statistics of the 100 Hz processing stages
+ **************************************************************************/
+
+#include "system_configuration.h"
+#include "main.h"
+#include "common.h"
+#include "ascii_support.h"
+#include "stage_timing.h"
+#include "fixed_point_format.h"
+
+COMMON loop_timing_t loop_timing;
+
+const char * const timing_stage_names[STAGE_COUNT] =
+  { "latch", "GNSS", "pressure", "10ms", "100ms", "CAN", "report", "total" };
+
+#if MEASURE_STAGE_TIMING
+
+//! @return histogram bin for a time in us
+static inline unsigned log2_bin( uint32_t usec)
+{
+  unsigned bin = 31 - __CLZ( usec | 1); // floor( log2( usec))
+  return bin < TIMING_HISTOGRAM_BINS ? bin : TIMING_HISTOGRAM_BINS - 1;
+}
+
+uint32_t stage_done( timing_stage_t stage, uint32_t start)
+{
+  uint32_t now = get_cycle_count();
+  uint32_t cycles = now - start;
+  stage_statistics_t & s = loop_timing.stage[stage];
+
+  if( (s.count == 0) || (cycles < s.min_cycles))
+    s.min_cycles = cycles;
+  if( cycles > s.max_cycles)
+    s.max_cycles = cycles;
+  s.sum_cycles += cycles;
+  ++s.count;
+
+  uint32_t usec = cycles / CPU_CYCLES_PER_USEC;
+  ++s.histogram[log2_bin( usec)];
+
+  if( (stage == STAGE_TOTAL) && (usec > CYCLE_DEADLINE_USEC))
+    ++loop_timing.deadline_misses;
+
+  return now;
+}
+
+void timing_on_DRDY( uint64_t time_usec)
+{
+  drdy_statistics_t & d = loop_timing.drdy;
+  uint32_t interval = (uint32_t)(time_usec - d.last_drdy_usec);
+  d.last_drdy_usec = time_usec;
+
+  if( ! d.armed)
+    {
+      d.decay_counter = 0; // restart rolling statistics
+      return;
+    }
+
+  if( ++d.phase >= IMU_OVERSAMPLING) // this DRDY triggers the communicator
+    {
+      d.phase = 0;
+      if( d.communicator_busy)
+	++d.overruns;
+    }
+
+  if( d.first_sample) // last_drdy_usec is from before arming, no valid interval
+    {
+      d.first_sample = false;
+      return;
+    }
+
+  if( interval > DRDY_PERIOD_USEC + DRDY_PERIOD_USEC / 2)
+    d.missed_cycles += (interval + DRDY_PERIOD_USEC / 2) / DRDY_PERIOD_USEC - 1;
+
+  uint32_t jitter = interval > DRDY_PERIOD_USEC ? interval - DRDY_PERIOD_USEC : DRDY_PERIOD_USEC - interval;
+
+  if( ++d.decay_counter >= JITTER_DECAY_SAMPLES)
+    {
+      d.decay_counter = 0;
+      d.max_jitter_usec = 0;
+      for( unsigned i = 0; i < TIMING_HISTOGRAM_BINS; ++i)
+	d.jitter_histogram[i] /= 2;
+    }
+
+  if( jitter > d.max_jitter_usec)
+    d.max_jitter_usec = jitter;
+  ++d.jitter_histogram[log2_bin( jitter)];
+}
+
+#endif
+
+char * format_timing_report_line( char * next, unsigned line)
+{
+  const drdy_statistics_t & d = loop_timing.drdy;
+  if( line == STAGE_COUNT)
+    {
+      next = append_string( next, "deadline_misses ");
+      next = format_unsigned( next, loop_timing.deadline_misses);
+      next = append_string( next, " overruns ");
+      next = format_unsigned( next, d.overruns);
+      next = append_string( next, " missed_cycles ");
+      next = format_unsigned( next, d.missed_cycles);
+      next = append_string( next, " imu_restarts ");
+      next = format_unsigned( next, d.imu_restarts);
+      next = append_string( next, " max_jitter ");
+      return format_unsigned( next, d.max_jitter_usec);
+    }
+  if( line > STAGE_COUNT)
+    {
+      next = append_string( next, "jitter");
+      for( unsigned k = 0; k < TIMING_HISTOGRAM_BINS; ++k)
+	{
+	  *next++ = ' ';
+	  next = format_unsigned( next, d.jitter_histogram[k]);
+	}
+      return next;
+    }
+
+  const stage_statistics_t & s = loop_timing.stage[line];
+  next = append_string( next, timing_stage_names[line]);
+  *next++ = ' ';
+  next = format_unsigned( next, s.count);
+  *next++ = ' ';
+  next = format_unsigned( next, s.min_cycles / CPU_CYCLES_PER_USEC);
+  *next++ = ' ';
+  next = format_unsigned( next, s.count ? (uint32_t)(s.sum_cycles / s.count / CPU_CYCLES_PER_USEC) : 0);
+  *next++ = ' ';
+  next = format_unsigned( next, s.max_cycles / CPU_CYCLES_PER_USEC);
+  for( unsigned k = 0; k < TIMING_HISTOGRAM_BINS; ++k)
+    {
+      *next++ = ' ';
+      next = format_unsigned( next, s.histogram[k]);
+    }
+  return next;
+}
+
+char * format_timing_sentence( char * next)
+{
+  NMEA_sentence sentence( next, "PLART");
+
+  for( unsigned i = 0; i < STAGE_COUNT; ++i)
+    sentence.unsigned_field( loop_timing.stage[i].max_cycles / CPU_CYCLES_PER_USEC);
+
+  return sentence
+      .unsigned_field( loop_timing.deadline_misses)
+      .unsigned_field( loop_timing.drdy.overruns)
+      .unsigned_field( loop_timing.drdy.missed_cycles)
+      .unsigned_field( loop_timing.drdy.imu_restarts)
+      .unsigned_field( loop_timing.drdy.max_jitter_usec)
+      .finish();
+}
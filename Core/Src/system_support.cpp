@@ -106,6 +106,26 @@ uint64_t getTime_usec(void)
   return retv;
 }
 
+static int get_cycle_count_helper(void *parameters)
+{
+  if( (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+    {
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CYCCNT = 0;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+  *(uint32_t *)parameters = DWT->CYCCNT;
+  return 0;
+}
+
+//! @return CPU clock cycle counter, callable from unprivileged tasks
+uint32_t get_cycle_count(void)
+{
+  uint32_t retv;
+  (void)call_function_privileged( &retv, get_cycle_count_helper);
+  return retv;
+}
+
 /**
  * @brief  This function handles FreeRTOS's Stack Overflow exception.
  */
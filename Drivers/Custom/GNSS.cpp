@@ -6,9 +6,10 @@
 #include "main.h"
 #include "common.h"
 #include "system_state.h"
+#include "UBX_parser.h"
 
-COMMON bool GNSS_new_data_ready;
 COMMON bool D_GNSS_new_data_ready;
+COMMON spsc_ring<GNSS_solution_t, GNSS_SOLUTION_QUEUE_SIZE> GNSS_solutions;
 COMMON int64_t FAT_time; //!< DOS FAT time for file usage
 
 #define SCALE_MM 0.001f
@@ -23,7 +24,8 @@ GNSS_type::GNSS_type( coordinates_t & coo) :
 		longitude_reference(0),
 		latitude_scale(	0.0f),
 		coordinates( coo),
-		num_SV(0)
+		num_SV(0),
+		iTOW_ms(0)
 	{}
 
 GNSS_Result GNSS_type::update(const uint8_t * data)
@@ -43,6 +45,8 @@ GNSS_Result GNSS_type::update(const uint8_t * data)
 	while( count --)
 	  *to++ = *from++;
 
+	iTOW_ms = pvt.iTOW;
+
 	// compute time since last sample has been recorded
 	int32_t day_time_ms =
 	    pvt.hour   * 3600000 +
@@ -118,8 +122,6 @@ GNSS_Result GNSS_type::update(const uint8_t * data)
 	coordinates.speed_motion    = pvt.gSpeed * SCALE_MM;
 	coordinates.heading_motion  = pvt.gTrack * 1e-5f;
 
-	GNSS_new_data_ready = true;
-
 	fix_type = (FIX_TYPE) (pvt.fix_type);
 	if( (pvt.fix_flags & 1) == 0)	// todo someday modify me for aerobatics support
 	//	if (( (pvt.fix_flags & 1) == 0) || (pvt.sAcc > 250)) // todo modify me for M9N GNSS support
@@ -193,3 +195,36 @@ GNSS_type::update_combined (uint8_t *data)
 
   return res;
 }
+
+typedef GNSS_Result (GNSS_type::*UBX_handler_t)( const uint8_t * data);
+
+//! UBX messages accepted from the receivers
+static const struct
+{
+  uint8_t UBX_class;
+  uint8_t id;
+  UBX_handler_t handler;
+} UBX_routes[] =
+{
+    { UBX_CLASS_NAV, UBX_NAV_PVT, 	&GNSS_type::update},
+    { UBX_CLASS_NAV, UBX_NAV_RELPOSNED, &GNSS_type::update_delta},
+};
+
+GNSS_Result
+GNSS_type::dispatch (const uint8_t *frame)
+{
+  for( const auto & route : UBX_routes)
+    if( (frame[2] == route.UBX_class) && (frame[3] == route.id))
+      return (this->*route.handler)( frame);
+  return GNSS_ERROR;
+}
+
+void
+GNSS_type::publish (uint64_t capture_time_usec, uint64_t measurement_time_usec)
+{
+  GNSS_solution_t solution;
+  solution.coordinates = coordinates;
+  solution.capture_time_usec = capture_time_usec;
+  solution.measurement_time_usec = measurement_time_usec;
+  GNSS_solutions.push( solution);
+}
@@ -9,12 +9,12 @@
 #include "system_configuration.h"
 #include "float3vector.h"
 #include "embedded_memory.h"
+#include "spsc_ring.h"
 
 enum { NORTH, EAST, DOWN};
 
 extern int64_t FAT_time; //!< DOS FAT time for file usage
 
-extern bool GNSS_new_data_ready;
 extern bool D_GNSS_new_data_ready;
 
 typedef struct
@@ -124,6 +124,18 @@ public:
   GNSS_Result update_delta( const uint8_t * data);
   GNSS_Result update_combined( uint8_t * data);
 
+  //! route a complete UBX frame by class and id, @return GNSS_ERROR for frames not handled
+  GNSS_Result dispatch( const uint8_t * frame);
+
+  //! hand the present solution over to the communicator
+  void publish( uint64_t capture_time_usec, uint64_t measurement_time_usec);
+
+  //! GPS time of week of the latest PVT epoch / ms
+  uint32_t get_iTOW_ms( void) const
+  {
+    return iTOW_ms;
+  }
+
   void reset_reference( void)
   {
     fix_type = FIX_none;
@@ -165,8 +177,21 @@ private:
   int32_t longitude_reference;
   float latitude_scale;
   unsigned old_timestamp_ms;
+  uint32_t iTOW_ms;
 };
 
 extern GNSS_type GNSS;
 
+#define GNSS_SOLUTION_QUEUE_SIZE 4
+
+//! decoded GNSS epoch on its way from the GNSS task to the communicator
+typedef struct
+{
+  coordinates_t coordinates;
+  uint64_t capture_time_usec; //!< getTime_usec() when the epoch has been received completely
+  uint64_t measurement_time_usec; //!< getTime_usec() time base, latency corrected
+} GNSS_solution_t;
+
+extern spsc_ring<GNSS_solution_t, GNSS_SOLUTION_QUEUE_SIZE> GNSS_solutions;
+
 #endif /* DRIVER_GPS_H_ */
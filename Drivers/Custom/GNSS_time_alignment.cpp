@@ -0,0 +1,31 @@
+/** ***********************************************************************
+ * @file		GNSS_time_alignment.cpp
+ * @brief		map GNSS epochs (iTOW) onto the CPU time base
+ **************************************************************************/
+
+#include "GNSS_time_alignment.h"
+
+uint64_t GNSS_time_alignment::update( uint64_t receive_time_usec, uint32_t iTOW_ms)
+{
+  int64_t offset = (int64_t)receive_time_usec - (int64_t)iTOW_ms * 1000;
+
+  if( valid) // allow for clock drift since the last epoch, us = ms * ppm / 1000
+    envelope += (int64_t)(uint32_t)(iTOW_ms - last_iTOW_ms) * GNSS_CLOCK_DRIFT_PPM / 1000;
+  last_iTOW_ms = iTOW_ms;
+
+  int64_t deviation = offset - envelope;
+  if( ! valid || deviation < 0 || deviation > GNSS_REALIGNMENT_THRESHOLD_USEC)
+    {
+      if( valid && (deviation < -GNSS_REALIGNMENT_THRESHOLD_USEC || deviation > GNSS_REALIGNMENT_THRESHOLD_USEC))
+	++realignments;
+      envelope = offset;
+      deviation = 0;
+      valid = true;
+    }
+
+  latency = (uint32_t)deviation + output_latency;
+  if( latency > max_latency)
+    max_latency = latency;
+
+  return (uint64_t)( (int64_t)iTOW_ms * 1000 + envelope) - output_latency;
+}
@@ -0,0 +1,45 @@
+/** ***********************************************************************
+ * @file		GNSS_time_alignment.h
+ * @brief		map GNSS epochs (iTOW) onto the CPU time base
+ *
+ * offset = receive time - iTOW is CPU-to-GPS clock offset plus transport latency.
+ * The latency varies from epoch to epoch (receiver load, message length,
+ * task scheduling) but never drops below the receiver's output latency.
+ * The lower envelope of the offset therefore yields a jitter-free mapping
+ * of the epoch time onto the CPU clock. It follows CPU clock drift upwards
+ * by GNSS_CLOCK_DRIFT_PPM and steps down immediately.
+ * The receiver's output latency itself is not observable without PPS signal,
+ * it is a configuration constant.
+ * Host check: Host_tools/GNSS_time_alignment_check.cpp
+ **************************************************************************/
+
+#ifndef CUSTOM_GNSS_TIME_ALIGNMENT_H_
+#define CUSTOM_GNSS_TIME_ALIGNMENT_H_
+
+#include "stdint.h"
+
+#define GNSS_CLOCK_DRIFT_PPM		100	// crystal tolerance CPU + receiver
+#define GNSS_REALIGNMENT_THRESHOLD_USEC	500000	// larger offset changes: week rollover or receiver restart
+
+class GNSS_time_alignment
+{
+public:
+  GNSS_time_alignment( uint32_t output_latency_usec)
+    : output_latency( output_latency_usec), latency(0), max_latency(0), realignments(0),
+      envelope(0), last_iTOW_ms(0), valid( false)
+  {}
+
+  //! @return CPU time when the epoch has been measured
+  uint64_t update( uint64_t receive_time_usec, uint32_t iTOW_ms);
+
+  uint32_t output_latency;	//!< receiver measurement -> end of transmission, configured
+  uint32_t latency;		//!< latest total latency
+  uint32_t max_latency;		//!< worst total latency since start
+  uint32_t realignments;	//!< envelope resets
+private:
+  int64_t envelope;		//!< lower envelope of receive time - iTOW
+  uint32_t last_iTOW_ms;
+  bool valid;
+};
+
+#endif /* CUSTOM_GNSS_TIME_ALIGNMENT_H_ */
@@ -0,0 +1,151 @@
+/** ***********************************************************************
+ * @file		I2C_scheduler.cpp
+ * @brief		interrupt driven transaction batches on one I2C bus
+ **************************************************************************/
+
+#include "I2C_scheduler.h"
+#include "common.h"
+
+static void I2C1_on_completion( I2C_StatusTypeDef status);
+static void I2C2_on_completion( I2C_StatusTypeDef status);
+
+COMMON I2C_scheduler I2C1_scheduler( &hi2c1, I2C1_on_completion);
+COMMON I2C_scheduler I2C2_scheduler( &hi2c2, I2C2_on_completion);
+
+static void I2C1_on_completion( I2C_StatusTypeDef status)
+{
+  I2C1_scheduler.on_completion( status);
+}
+
+static void I2C2_on_completion( I2C_StatusTypeDef status)
+{
+  I2C2_scheduler.on_completion( status);
+}
+
+bool I2C_scheduler::add( I2C_transaction_t & transaction)
+{
+  if( count >= I2C_MAX_TRANSACTIONS)
+    return false;
+
+  // behind all transactions of the same or higher priority
+  unsigned position = count;
+  while( position > 0 && queue[position - 1]->device->priority > transaction.device->priority)
+    {
+      queue[position] = queue[position - 1];
+      --position;
+    }
+  queue[position] = &transaction;
+  ++count;
+  return true;
+}
+
+void I2C_scheduler::start( void)
+{
+  if( count == 0)
+    return;
+  current = 0;
+  busy = true;
+  if( start_next())
+    {
+      busy = false;
+      done.signal();
+    }
+}
+
+//! start queue[current] or the first one after it that can be started, @return true if none left
+bool I2C_scheduler::start_next( void)
+{
+  while( current < count)
+    {
+      I2C_transaction_t & t = *queue[current];
+      HAL_StatusTypeDef status = HAL_ERROR;
+      switch( t.type)
+      {
+	case I2C_TRANSFER_READ:
+	  status = HAL_I2C_Master_Receive_IT( bus, t.device->address, t.data, t.size);
+	  break;
+	case I2C_TRANSFER_WRITE:
+	  status = HAL_I2C_Master_Transmit_IT( bus, t.device->address, t.data, t.size);
+	  break;
+	case I2C_TRANSFER_READ_REGISTER:
+	  status = HAL_I2C_Mem_Read_IT( bus, t.device->address, t.reg, I2C_MEMADD_SIZE_8BIT, t.data, t.size);
+	  break;
+	case I2C_TRANSFER_WRITE_REGISTER:
+	  status = HAL_I2C_Mem_Write_IT( bus, t.device->address, t.reg, I2C_MEMADD_SIZE_8BIT, t.data, t.size);
+	  break;
+      }
+      if( status == HAL_OK)
+	return false; // on_completion() continues
+
+      t.status = I2C_ERROR;
+      ++t.device->transfers;
+      ++t.device->errors;
+      ++t.device->consecutive_errors;
+      ++current;
+    }
+  return true;
+}
+
+void I2C_scheduler::on_completion( I2C_StatusTypeDef status)
+{
+  if( ! busy || current >= count) // late interrupt after a recovery
+    return;
+
+  I2C_transaction_t & t = *queue[current];
+  t.status = status;
+  ++t.device->transfers;
+  if( status == I2C_OK)
+    t.device->consecutive_errors = 0;
+  else
+    {
+      ++t.device->errors;
+      ++t.device->consecutive_errors;
+    }
+
+  ++current;
+  if( start_next())
+    {
+      busy = false;
+      done.signal_from_ISR();
+    }
+}
+
+bool I2C_scheduler::finish( void)
+{
+  if( count == 0)
+    return true;
+
+  bool in_time = done.wait( I2C_BATCH_TIMEOUT_MS);
+
+  bool any_success = false;
+  if( in_time)
+    for( unsigned i = 0; i < count; ++i)
+      if( queue[i]->status == I2C_OK)
+	any_success = true;
+
+  if( any_success)
+    return true;
+
+  if( ! in_time)
+    {
+      taskENTER_CRITICAL();
+      busy = false;
+      taskEXIT_CRITICAL();
+      for( unsigned i = current; i < count; ++i)
+	{
+	  queue[i]->status = I2C_ERROR;
+	  ++queue[i]->device->transfers;
+	  ++queue[i]->device->errors;
+	  ++queue[i]->device->consecutive_errors;
+	}
+    }
+  recover();
+  return false;
+}
+
+void I2C_scheduler::recover( void)
+{
+  ++recoveries;
+  I2C_Recover( bus);
+  done.wait( 0); // drop a completion that arrived after the timeout
+}
@@ -0,0 +1,109 @@
+/** ***********************************************************************
+ * @file		I2C_scheduler.h
+ * @brief		interrupt driven transaction batches on one I2C bus
+ *
+ * Each device owns pre-built transactions which are queued once per cycle.
+ * The batch is ordered by device priority, a device's own transactions
+ * keep their order. The completion interrupt starts the next transaction,
+ * the task is woken when the whole batch has finished.
+ * A batch which does not finish in time or fails completely
+ * causes a bus recovery by clock pulsing.
+ **************************************************************************/
+
+#ifndef CUSTOM_I2C_SCHEDULER_H_
+#define CUSTOM_I2C_SCHEDULER_H_
+
+#include "i2c.h"
+#include "FreeRTOS_wrapper.h"
+
+#define I2C_MAX_TRANSACTIONS		8	// per bus and cycle
+#define I2C_BATCH_TIMEOUT_MS		5	// 8 short transactions @ 400 kHz need < 2 ms
+#define I2C_MAX_CONSECUTIVE_ERRORS	10	// device is re-initialized then
+
+enum I2C_transfer_type_t
+{
+  I2C_TRANSFER_READ,
+  I2C_TRANSFER_WRITE,
+  I2C_TRANSFER_READ_REGISTER,
+  I2C_TRANSFER_WRITE_REGISTER
+};
+
+//! one slave on the bus, the counters are written by the scheduler only
+struct I2C_device_t
+{
+  I2C_device_t( uint16_t address, uint8_t priority)
+    : address( address), priority( priority), transfers( 0), errors( 0), consecutive_errors( 0)
+  {}
+  uint16_t address;		//!< 7 bits left-adjusted
+  uint8_t priority;		//!< 0 = first on the bus
+  uint32_t transfers;
+  uint32_t errors;
+  uint32_t consecutive_errors;
+};
+
+//! pre-built transfer, status is valid after the batch has finished
+struct I2C_transaction_t
+{
+  I2C_device_t * device;
+  I2C_transfer_type_t type;
+  uint8_t reg;			//!< register address, REGISTER types only
+  uint8_t * data;
+  uint16_t size;
+  I2C_StatusTypeDef status;
+};
+
+class I2C_scheduler
+{
+public:
+  I2C_scheduler( I2C_HandleTypeDef * hi2c, I2C_CompletionHandler_t handler)
+    : recoveries( 0), bus( hi2c), completion_handler( handler), count( 0), current( 0), busy( false)
+  {}
+
+  //! interrupt driven operation, blocking I2C functions are unavailable then
+  void enable( void)
+  {
+    I2C_SetCompletionHandler( bus, completion_handler);
+  }
+
+  //! back to the blocking I2C functions, used for device initialization
+  void disable( void)
+  {
+    I2C_SetCompletionHandler( bus, 0);
+  }
+
+  //! start a new batch
+  void clear( void)
+  {
+    count = 0;
+  }
+
+  //! queue a transaction for this cycle, @return false if the batch is full
+  bool add( I2C_transaction_t & transaction);
+
+  //! start the batch, a batch without transactions is finished immediately
+  void start( void);
+
+  //! wait for the batch and recover the bus if necessary, @return true if the bus has worked
+  bool finish( void);
+
+  //! completion interrupt
+  void on_completion( I2C_StatusTypeDef status);
+
+  uint32_t recoveries;		//!< bus lock-ups resolved by clock pulsing
+private:
+  bool start_next( void);
+  void recover( void);
+
+  I2C_HandleTypeDef * bus;
+  I2C_CompletionHandler_t completion_handler;
+  I2C_transaction_t * queue[I2C_MAX_TRANSACTIONS];
+  unsigned count;
+  volatile unsigned current;
+  volatile bool busy;
+  Semaphore done;
+};
+
+extern I2C_scheduler I2C1_scheduler;
+extern I2C_scheduler I2C2_scheduler;
+
+#endif /* CUSTOM_I2C_SCHEDULER_H_ */
@@ -0,0 +1,143 @@
+/** ***********************************************************************
+ * @file		IMU_decimator.cpp
+ * @brief		anti-alias filter and decimator for oversampled IMU data
+ **************************************************************************/
+
+#include "IMU_decimator.h"
+
+// first halves of the symmetric FIRs, sum of all taps = 1
+// equiripple design: pass band 0 .. 20 Hz, stop band 50 Hz .. fs/2, stop band weight 10
+
+//! 400 Hz input, 40 taps, < -63.0 dB @ 50 .. 200 Hz
+static constexpr float coefficients_400Hz[IMU_DECIMATOR_MAX_TAPS / 2] =
+{
+    -1.95096478e-04f, 7.09085633e-04f, 1.86421872e-03f, 3.53696783e-03f,
+    5.19752860e-03f, 5.99588376e-03f, 4.94109553e-03f, 1.27830491e-03f,
+    -5.04785501e-03f, -1.30159225e-02f, -2.04216114e-02f, -2.41693663e-02f,
+    -2.09714134e-02f, -8.31214274e-03f, 1.45969694e-02f, 4.61913155e-02f,
+    8.25104983e-02f, 1.17843818e-01f, 1.45948084e-01f, 1.61519638e-01f
+};
+
+//! 200 Hz input, 20 taps, < -62.6 dB @ 50 .. 100 Hz
+static constexpr float coefficients_200Hz[10] =
+{
+    6.17686371e-04f, 5.52886763e-03f, 1.14155736e-02f, 6.51609548e-03f,
+    -1.82361196e-02f, -4.58136663e-02f, -3.12472438e-02f, 5.95546085e-02f,
+    2.01292695e-01f, 3.10371504e-01f
+};
+
+static inline void cross_product_add( float * target, const float * a, const float * b, float factor)
+{
+  target[0] += factor * (a[1] * b[2] - a[2] * b[1]);
+  target[1] += factor * (a[2] * b[0] - a[0] * b[2]);
+  target[2] += factor * (a[0] * b[1] - a[1] * b[0]);
+}
+
+IMU_decimator::IMU_decimator( unsigned factor, float input_sample_time)
+  : coefficients( factor == 2 ? coefficients_200Hz : coefficients_400Hz),
+    taps( factor == 2 ? 20 : IMU_DECIMATOR_MAX_TAPS),
+    decimation( factor), T( input_sample_time)
+{
+  reset();
+}
+
+void IMU_decimator::reset( void)
+{
+  for( unsigned channel = 0; channel < CHANNELS; ++channel)
+    for( unsigned i = 0; i < 2 * IMU_DECIMATOR_MAX_TAPS; ++i)
+      history[channel][i] = 0.0f;
+  position = 0;
+  phase = 0;
+  for( unsigned i = 0; i < 3; ++i)
+    mag[i] = 0.0f;
+  mag_samples = 0;
+  mag_position = 0;
+  input_count = 0;
+}
+
+void IMU_decimator::feed_mag( const float mag_in[3])
+{
+  if( ++mag_position >= IMU_DECIMATOR_MAG_SAMPLES)
+    mag_position = 0;
+  for( unsigned i = 0; i < 3; ++i)
+    mag_history[mag_position][i] = mag_in[i];
+  mag_stamp[mag_position] = input_count;
+  if( mag_samples < IMU_DECIMATOR_MAG_SAMPLES)
+    ++mag_samples;
+}
+
+//! magnetometer at the filter window center, between the two samples around it
+void IMU_decimator::interpolate_mag( void)
+{
+  const float delay = 0.5f * (taps - 1); // input samples
+  const float * newer = 0;
+  float newer_age = 0.0f;
+  unsigned index = mag_position;
+  for( unsigned n = 0; n < mag_samples; ++n)
+    {
+      float age = (float)(input_count - 1 - mag_stamp[index]);
+      const float * sample = mag_history[index];
+      if( age >= delay)
+	{
+	  float weight = newer ? (age - delay) / (age - newer_age) : 0.0f;
+	  for( unsigned i = 0; i < 3; ++i)
+	    mag[i] = sample[i] + weight * ((newer ? newer[i] : sample[i]) - sample[i]);
+	  return;
+	}
+      newer = sample;
+      newer_age = age;
+      index = index == 0 ? IMU_DECIMATOR_MAG_SAMPLES - 1 : index - 1;
+    }
+  if( newer) // no sample old enough yet: the oldest one
+    for( unsigned i = 0; i < 3; ++i)
+      mag[i] = newer[i];
+}
+
+bool IMU_decimator::feed( const float acc_in[3], const float gyro_in[3])
+{
+  for( unsigned i = 0; i < 3; ++i)
+    {
+      history[ACC_X + i][position] = history[ACC_X + i][position + taps] = acc_in[i];
+      history[GYRO_X + i][position] = history[GYRO_X + i][position + taps] = gyro_in[i];
+    }
+  if( ++position >= taps)
+    position = 0;
+  ++input_count;
+
+  if( ++phase < decimation)
+    return false;
+  phase = 0;
+
+  // FIR output at the decimated rate only, oldest sample at history[channel][position]
+  for( unsigned channel = 0; channel < CHANNELS; ++channel)
+    {
+      const float * window = &history[channel][position];
+      float sum = 0.0f;
+      for( unsigned k = 0; k < taps / 2; ++k)
+	sum += coefficients[k] * (window[k] + window[taps - 1 - k]);
+      if( channel < GYRO_X)
+	acc[channel - ACC_X] = sum;
+      else
+	gyro[channel - GYRO_X] = sum;
+    }
+
+  // coning over the "decimation" sub-samples centered at the FIR group delay (taps - 1) / 2
+  float alpha[3] = { 0.0f, 0.0f, 0.0f};
+  float coning[3] = { 0.0f, 0.0f, 0.0f};
+  for( unsigned k = (taps - decimation) / 2; k < (taps + decimation) / 2; ++k)
+    {
+      float d_alpha[3];
+      for( unsigned i = 0; i < 3; ++i)
+	d_alpha[i] = history[GYRO_X + i][position + k] * T;
+      cross_product_add( coning, alpha, d_alpha, 0.5f);
+      for( unsigned i = 0; i < 3; ++i)
+	alpha[i] += d_alpha[i];
+    }
+
+  float output_rate = 1.0f / (decimation * T);
+  for( unsigned i = 0; i < 3; ++i)
+    gyro[i] += coning[i] * output_rate;
+
+  interpolate_mag();
+  return true;
+}
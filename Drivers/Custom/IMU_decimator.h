@@ -0,0 +1,80 @@
+/** ***********************************************************************
+ * @file		IMU_decimator.h
+ * @brief		anti-alias filter and decimator for oversampled IMU data
+ *
+ * Acceleration and rotation rate are low-pass filtered by a symmetric
+ * equiripple FIR which is evaluated only at the output rate.
+ * Both tables have 0 .. 20 Hz pass band (-0.13 dB worst case) and
+ * < -62 dB from 50 Hz upwards, so content in 50 .. 150 Hz which would alias
+ * into the 100 Hz output is suppressed by more than 62 dB.
+ * 400 Hz input: 40 taps, 200 Hz input: 20 taps, group delay 48.75 / 47.5 ms.
+ * The first-order coning correction is computed over the output interval
+ * at the center of the filter window, i.e. aligned with the FIR delay,
+ * and added to the filtered rotation rate for the rate-based attitude filter.
+ * The magnetometer arrives at 100 Hz or less, unfiltered. It is delayed by
+ * the same group delay, interpolating linearly between its samples,
+ * so all three vectors refer to the same instant.
+ * Host check: Host_tools/IMU_decimator_check.cpp
+ **************************************************************************/
+
+#ifndef CUSTOM_IMU_DECIMATOR_H_
+#define CUSTOM_IMU_DECIMATOR_H_
+
+#include "stdint.h"
+
+#define IMU_DECIMATOR_MAX_TAPS	40
+#define IMU_DECIMATOR_MAG_SAMPLES	8 // covers the group delay at 100 Hz magnetometer rate
+
+class IMU_decimator
+{
+public:
+  //! @param factor 2 (200 Hz input) or 4 (400 Hz input)
+  IMU_decimator( unsigned factor, float input_sample_time);
+
+  void reset( void);
+
+  //! feed one input sample, @return true if a new output sample is available
+  bool feed( const float acc_in[3], const float gyro_in[3]);
+
+  //! magnetometer sample measured together with the next input sample
+  void feed_mag( const float mag_in[3]);
+
+  //! group delay in microseconds for a decimation factor to 100 Hz, 0 without decimation
+  static constexpr uint32_t group_delay_usec( unsigned factor)
+  {
+    return factor < 2 ? 0 : ((factor == 2 ? 20 : IMU_DECIMATOR_MAX_TAPS) - 1) * 500000 / (100 * factor);
+  }
+
+  //! group delay of this instance in seconds
+  float group_delay( void) const
+  {
+    return 0.5f * (taps - 1) * T;
+  }
+
+  // output sample, valid after feed() has returned true
+  float acc[3];		//!< filtered specific force
+  float gyro[3];	//!< filtered rotation rate including the coning correction
+  float mag[3];		//!< magnetic field, delayed like acc and gyro
+private:
+  void interpolate_mag( void);
+
+  enum { ACC_X, ACC_Y, ACC_Z, GYRO_X, GYRO_Y, GYRO_Z, CHANNELS};
+
+  //! each sample is stored twice: the filter window is always contiguous
+  float history[CHANNELS][2 * IMU_DECIMATOR_MAX_TAPS];
+  const float * coefficients; //!< first half of the symmetric FIR
+  unsigned taps;
+  unsigned position;
+  unsigned phase;
+  unsigned decimation;
+  float T;
+
+  //! magnetometer samples, stamped with the number of the input sample they came with
+  float mag_history[IMU_DECIMATOR_MAG_SAMPLES][3];
+  uint32_t mag_stamp[IMU_DECIMATOR_MAG_SAMPLES];
+  unsigned mag_samples;		//!< valid entries, newest at mag_position
+  unsigned mag_position;
+  uint32_t input_count;
+};
+
+#endif /* CUSTOM_IMU_DECIMATOR_H_ */
@@ -0,0 +1,103 @@
+/** ***********************************************************************
+ * @file		UBX_configuration.cpp
+ * @brief		uBlox receiver configuration at boot time using UBX-CFG-VALSET
+ **************************************************************************/
+
+#include "UBX_configuration.h"
+#include "UBX_parser.h"
+
+#define UBX_LAYER_RAM	0x01
+
+#define CFG_RATE_MEAS				0x30210001 // U2 ms
+#define CFG_RATE_NAV				0x30210002 // U2 cycles
+#define CFG_UART1OUTPROT_UBX			0x10740001 // L
+#define CFG_UART1OUTPROT_NMEA			0x10740002 // L
+#define CFG_MSGOUT_UBX_NAV_PVT_UART1		0x20910007 // U1 rate
+#define CFG_MSGOUT_UBX_NAV_RELPOSNED_UART1	0x2091008e // U1 rate
+#define CFG_UART1_BAUDRATE			0x40520001 // U4
+
+enum { FOR_PVT = 1 << UBX_PVT, FOR_PVT_RELPOSNED = 1 << UBX_PVT_RELPOSNED, FOR_RELPOSNED = 1 << UBX_RELPOSNED};
+#define FOR_ALL (FOR_PVT | FOR_PVT_RELPOSNED | FOR_RELPOSNED)
+
+typedef struct
+{
+  uint32_t key;
+  uint32_t value;
+  uint8_t roles;
+} configuration_item_t;
+
+//! values taken from Configuration_files/Ardusimple_*.txt, baud rate appended at runtime
+static const configuration_item_t configuration[] =
+{
+    { CFG_RATE_MEAS, 			100,	FOR_ALL}, // 10 Hz
+    { CFG_RATE_NAV, 			1,	FOR_ALL},
+    { CFG_UART1OUTPROT_UBX, 		1,	FOR_ALL},
+    { CFG_UART1OUTPROT_NMEA, 		0,	FOR_ALL},
+    { CFG_MSGOUT_UBX_NAV_PVT_UART1, 	1,	FOR_PVT | FOR_PVT_RELPOSNED},
+    { CFG_MSGOUT_UBX_NAV_PVT_UART1, 	0,	FOR_RELPOSNED},
+    { CFG_MSGOUT_UBX_NAV_RELPOSNED_UART1, 1,	FOR_PVT_RELPOSNED | FOR_RELPOSNED},
+    // no RELPOSNED key for FOR_PVT: the M9N would reject the whole message
+};
+
+//! @return value size in bytes as coded within the key ID
+static inline unsigned value_size( uint32_t key)
+{
+  switch( (key >> 28) & 0x07)
+  {
+    case 3:
+      return 2;
+    case 4:
+      return 4;
+    case 5:
+      return 8;
+    default: // 1 bit or 1 byte
+      return 1;
+  }
+}
+
+static uint8_t * append_item( uint8_t * next, uint32_t key, uint32_t value)
+{
+  for( unsigned i = 0; i < 4; ++i)
+    *next++ = (uint8_t)( key >> (8 * i));
+  unsigned size = value_size( key);
+  for( unsigned i = 0; i < size; ++i)
+    *next++ = i < 4 ? (uint8_t)( value >> (8 * i)) : 0;
+  return next;
+}
+
+unsigned make_UBX_configuration( uint8_t * frame, UBX_receiver_role_t role, uint32_t baudrate)
+{
+  uint8_t * next = frame;
+  *next++ = UBX_SYNC_1;
+  *next++ = UBX_SYNC_2;
+  *next++ = UBX_CLASS_CFG;
+  *next++ = UBX_CFG_VALSET;
+  next += 2; // length, filled in below
+
+  *next++ = 0; // version
+  *next++ = UBX_LAYER_RAM; // not persistent: configuration is repeated at every boot
+  *next++ = 0; // reserved
+  *next++ = 0;
+
+  for( const configuration_item_t & item : configuration)
+    if( item.roles & (1 << role))
+      next = append_item( next, item.key, item.value);
+
+  // the receiver switches the baud rate after this message
+  next = append_item( next, CFG_UART1_BAUDRATE, baudrate);
+
+  unsigned length = next - frame - 6;
+  frame[4] = (uint8_t)length;
+  frame[5] = (uint8_t)(length >> 8);
+
+  uint8_t CK_A = 0, CK_B = 0;
+  for( uint8_t * p = frame + 2; p < next; ++p)
+    {
+      CK_A = CK_A + *p;
+      CK_B = CK_B + CK_A;
+    }
+  *next++ = CK_A;
+  *next++ = CK_B;
+
+  return next - frame;
+}
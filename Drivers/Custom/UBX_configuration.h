@@ -0,0 +1,33 @@
+/** ***********************************************************************
+ * @file		UBX_configuration.h
+ * @brief		uBlox receiver configuration at boot time using UBX-CFG-VALSET
+ *
+ * Only the settings the firmware depends on are sent, into the RAM layer.
+ * All other settings are taken from the receiver's flash,
+ * see the dumps in Configuration_files/.
+ **************************************************************************/
+
+#ifndef CUSTOM_UBX_CONFIGURATION_H_
+#define CUSTOM_UBX_CONFIGURATION_H_
+
+#include "stdint.h"
+
+#define UBX_CLASS_CFG		0x06
+#define UBX_CFG_VALSET		0x8a
+#define UBX_CLASS_ACK		0x05
+#define UBX_ACK_ACK		0x01
+
+#define UBX_CONFIGURATION_MAX_FRAME	128
+
+//! what the receiver has to deliver on its UART1
+enum UBX_receiver_role_t
+{
+  UBX_PVT,		//!< single GNSS receiver: M9N, F9P in F9P + F9H setup
+  UBX_PVT_RELPOSNED,	//!< F9P rover of the F9P + F9P setup
+  UBX_RELPOSNED		//!< F9H heading receiver
+};
+
+//! build a CFG-VALSET frame, @return frame size in bytes
+unsigned make_UBX_configuration( uint8_t * frame, UBX_receiver_role_t role, uint32_t baudrate);
+
+#endif /* CUSTOM_UBX_CONFIGURATION_H_ */
@@ -0,0 +1,89 @@
+/** ***********************************************************************
+ * @file		UBX_parser.cpp
+ * @brief		incremental uBlox UBX protocol framing
+ **************************************************************************/
+
+#include "UBX_parser.h"
+
+bool UBX_parser::feed( uint8_t byte)
+{
+  switch( state)
+  {
+    case WAIT_SYNC_1:
+      if( byte == UBX_SYNC_1)
+	state = WAIT_SYNC_2;
+      break;
+    case WAIT_SYNC_2:
+      if( byte == UBX_SYNC_2)
+	state = WAIT_CLASS;
+      else if( byte != UBX_SYNC_1) // 0xb5 0xb5 'b' is a valid start
+	state = WAIT_SYNC_1;
+      break;
+    case WAIT_CLASS:
+      frame[0] = UBX_SYNC_1;
+      frame[1] = UBX_SYNC_2;
+      frame[2] = byte;
+      CK_A = CK_B = 0;
+      checksum( byte);
+      state = WAIT_ID;
+      break;
+    case WAIT_ID:
+      frame[3] = byte;
+      checksum( byte);
+      state = WAIT_LENGTH_LOW;
+      break;
+    case WAIT_LENGTH_LOW:
+      frame[4] = byte;
+      length = byte;
+      checksum( byte);
+      state = WAIT_LENGTH_HIGH;
+      break;
+    case WAIT_LENGTH_HIGH:
+      frame[5] = byte;
+      length |= (uint16_t)byte << 8;
+      checksum( byte);
+      if( length > UBX_MAX_PAYLOAD)
+	{
+	  ++oversized_frames;
+	  state = WAIT_SYNC_1; // resynchronize on the next frame
+	}
+      else
+	{
+	  received = 0;
+	  state = length ? WAIT_PAYLOAD : WAIT_CK_A;
+	}
+      break;
+    case WAIT_PAYLOAD:
+      frame[6 + received] = byte;
+      checksum( byte);
+      if( ++received == length)
+	state = WAIT_CK_A;
+      break;
+    case WAIT_CK_A:
+      frame[6 + length] = byte;
+      if( byte == CK_A)
+	state = WAIT_CK_B;
+      else
+	{
+	  ++checksum_errors;
+	  state = byte == UBX_SYNC_1 ? WAIT_SYNC_2 : WAIT_SYNC_1;
+	}
+      break;
+    case WAIT_CK_B:
+      frame[7 + length] = byte;
+      state = WAIT_SYNC_1;
+      if( byte == CK_B)
+	{
+	  ++frames;
+	  return true;
+	}
+      ++checksum_errors;
+      if( byte == UBX_SYNC_1)
+	state = WAIT_SYNC_2;
+      break;
+    default:
+      state = WAIT_SYNC_1;
+      break;
+  }
+  return false;
+}
@@ -0,0 +1,78 @@
+/** ***********************************************************************
+ * @file		UBX_parser.h
+ * @brief		incremental uBlox UBX protocol framing
+ *
+ * Bytes are fed one by one from a continuous stream.
+ * A frame is recognized at any offset by its sync characters,
+ * length and Fletcher checksum. Garbage and corrupted frames are skipped.
+ * The assembled frame "0xb5 'b' class id length payload CK_A CK_B"
+ * is the format GNSS_type::update() expects.
+ * Host check: Host_tools/UBX_parser_check.cpp
+ **************************************************************************/
+
+#ifndef CUSTOM_UBX_PARSER_H_
+#define CUSTOM_UBX_PARSER_H_
+
+#include "stdint.h"
+
+#define UBX_SYNC_1		0xb5
+#define UBX_SYNC_2		0x62	// 'b'
+#define UBX_FRAME_OVERHEAD	8	// sync 2, class, id, length 2, checksum 2
+#define UBX_MAX_PAYLOAD		256	// longer frames are skipped
+
+#define UBX_CLASS_NAV		0x01
+#define UBX_NAV_PVT		0x07
+#define UBX_NAV_RELPOSNED	0x3c
+
+class UBX_parser
+{
+public:
+  UBX_parser( void)
+    : frames(0), checksum_errors(0), oversized_frames(0),
+      state( WAIT_SYNC_1), length(0), received(0), CK_A(0), CK_B(0)
+  {}
+
+  //! @return true if a frame with valid checksum has been completed by this byte
+  bool feed( uint8_t byte);
+
+  //! complete frame, valid until the next call of feed()
+  const uint8_t * get_frame( void) const
+  {
+    return frame;
+  }
+  uint8_t get_class( void) const
+  {
+    return frame[2];
+  }
+  uint8_t get_id( void) const
+  {
+    return frame[3];
+  }
+  uint16_t get_payload_length( void) const
+  {
+    return length;
+  }
+
+  uint32_t frames;		//!< frames received
+  uint32_t checksum_errors;	//!< frames dropped due to checksum mismatch
+  uint32_t oversized_frames;	//!< frames skipped due to length > UBX_MAX_PAYLOAD
+private:
+  enum
+  {
+    WAIT_SYNC_1, WAIT_SYNC_2, WAIT_CLASS, WAIT_ID, WAIT_LENGTH_LOW, WAIT_LENGTH_HIGH,
+    WAIT_PAYLOAD, WAIT_CK_A, WAIT_CK_B
+  } state;
+  uint16_t length;
+  uint16_t received;
+  uint8_t CK_A;
+  uint8_t CK_B;
+  uint8_t frame[UBX_MAX_PAYLOAD + UBX_FRAME_OVERHEAD] __attribute__((aligned(4)));
+
+  void checksum( uint8_t byte)
+  {
+    CK_A = CK_A + byte;
+    CK_B = CK_B + CK_A;
+  }
+};
+
+#endif /* CUSTOM_UBX_PARSER_H_ */
@@ -235,6 +235,16 @@ void Bluetooth_Transmit(uint8_t *pData, uint16_t Size)
     }
 }
 
+bool Bluetooth_connected(void)
+{
+  return ble_connected;
+}
+
+bool Bluetooth_Transmit_IT(uint8_t *pData, uint16_t Size)
+{
+  return UART6_Transmit_IT(pData, Size);
+}
+
 bool Bluetooth_Receive(uint8_t *pRxByte, uint32_t timeout)
 {
   return UART6_Receive(pRxByte, timeout);
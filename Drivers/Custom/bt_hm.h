@@ -17,6 +17,8 @@
 
 bool Bluetooth_Init(void);
 void Bluetooth_Transmit(uint8_t *pData, uint16_t Size);
+bool Bluetooth_Transmit_IT(uint8_t *pData, uint16_t Size); // non-blocking, see UART_set_transmit_complete_handler
+bool Bluetooth_connected(void);
 bool Bluetooth_Receive(uint8_t *pRxByte, uint32_t timeout);
 
 #ifdef __cplusplus
@@ -19,7 +19,6 @@
 #define FXOS8700_ID (0xC7) // 1100 0111
 
 #define FXOS8700_I2C  &hi2c1
-#define FXOS8700_I2C_ADDR 0x3C
 
 bool FXOS8700_write(uint8_t reg, uint8_t *tx_data, uint8_t length)
 {
@@ -86,39 +85,31 @@ bool FXOS8700_Initialize(fxos8700AccelRange_t range)
 	return true;
 }
 
-#define RX_DATA_SIZE 13
-COMMON static uint8_t rx_data[RX_DATA_SIZE];
-bool FXOS8700_get(float* xyz_acc, float* xyz_mag)
+void FXOS8700_decode(const uint8_t* rx_data, float* xyz_acc, float* xyz_mag)
 {
+	/*TODO: Evaluate rx_data[0] status values might activate interrupts for new conversion done trigger*/
 
-	if(true == FXOS8700_read(FXOS8700_REGISTER_STATUS, rx_data, RX_DATA_SIZE))
+	float acceleration_conversion_factor = 0;
+	if (ACCEL_RANGE_2G == FXOS8700_range)
 	{
-		/*TODO: Evaluate rx_data[0] status values might activate interrupts for new conversion done trigger*/
-
-		float acceleration_conversion_factor = 0;
-		if (ACCEL_RANGE_2G == FXOS8700_range)
-		{
-			acceleration_conversion_factor = ACCEL_MG_LSB_2G * ACCEL_GRAVITY_MS2;
-		}
-		else if (ACCEL_RANGE_4G == FXOS8700_range)
-		{
-			acceleration_conversion_factor = ACCEL_MG_LSB_4G * ACCEL_GRAVITY_MS2;
-		}
-		else if (ACCEL_RANGE_8G == FXOS8700_range)
-		{
-			acceleration_conversion_factor = ACCEL_MG_LSB_8G * ACCEL_GRAVITY_MS2;
-		}
-		else
-		{
-			ASSERT(0);
-		}
-
-		for(int i = 0; i<3; i++)
-		{
-			xyz_acc[i] = (float)((int16_t)((rx_data[(i*2)+1] << 8)  | (rx_data[(i*2)+2])) >> 2) * acceleration_conversion_factor ;
-			xyz_mag[i] = ((float)(int16_t)((rx_data[(i*2)+7] << 8)  | rx_data[(i*2)+8])) * MAG_UT_LSB;
-		}
-		return true;
+		acceleration_conversion_factor = ACCEL_MG_LSB_2G * ACCEL_GRAVITY_MS2;
+	}
+	else if (ACCEL_RANGE_4G == FXOS8700_range)
+	{
+		acceleration_conversion_factor = ACCEL_MG_LSB_4G * ACCEL_GRAVITY_MS2;
+	}
+	else if (ACCEL_RANGE_8G == FXOS8700_range)
+	{
+		acceleration_conversion_factor = ACCEL_MG_LSB_8G * ACCEL_GRAVITY_MS2;
+	}
+	else
+	{
+		ASSERT(0);
+	}
+
+	for(int i = 0; i<3; i++)
+	{
+		xyz_acc[i] = (float)((int16_t)((rx_data[(i*2)+1] << 8)  | (rx_data[(i*2)+2])) >> 2) * acceleration_conversion_factor ;
+		xyz_mag[i] = ((float)(int16_t)((rx_data[(i*2)+7] << 8)  | rx_data[(i*2)+8])) * MAG_UT_LSB;
 	}
-	return false;
 }
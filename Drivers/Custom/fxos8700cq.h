@@ -76,8 +76,11 @@ typedef struct {
 } fxos8700RawData_t;
 
 
+#define FXOS8700_I2C_ADDR 0x3C
+#define FXOS8700_DATA_SIZE 13 /* status, acc, mag: read starting at FXOS8700_REGISTER_STATUS */
+
 bool FXOS8700_Initialize(fxos8700AccelRange_t range);
-bool FXOS8700_get(float* xyz_acc, float* xyz_mag);
+void FXOS8700_decode(const uint8_t* rx_data, float* xyz_acc, float* xyz_mag); /* FXOS8700_DATA_SIZE bytes */
 
 #ifdef __cplusplus
 }
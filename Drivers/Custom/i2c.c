@@ -11,10 +11,14 @@
 #include "FreeRTOS_wrapper.h"
 #include "queue.h"
 #define I2C_DEFAULT_TIMEOUT_MS  100
+#define I2C_RECOVERY_MAX_TOGGLES 18 // 9 clock pulses release any slave in the middle of a byte
 
 static COMMON QueueHandle_t I2C1_CPL_Message_Id = NULL;
 static COMMON QueueHandle_t I2C2_CPL_Message_Id = NULL;
 
+static COMMON I2C_CompletionHandler_t I2C1_completion_handler = NULL;
+static COMMON I2C_CompletionHandler_t I2C2_completion_handler = NULL;
+
 /**
  * @brief I2C1 Initialization Function
  * @param None
@@ -102,12 +106,15 @@ static void I2C1_ResolveStuckSlave(void)
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
 	HAL_GPIO_Init(I2C1_SCL_GPIOX, &GPIO_InitStruct);
 
-	/* Generate clock pulses until slave releases the data line */
-	while(HAL_GPIO_ReadPin(I2C1_SDA_GPIOX, I2C1_SDA_GPIOPIN) == GPIO_PIN_RESET)
+	/* Generate clock pulses until slave releases the data line, give up on a shorted bus */
+	HAL_GPIO_WritePin(I2C1_SCL_GPIOX, I2C1_SCL_GPIOPIN, GPIO_PIN_SET);
+	for (unsigned toggles = 0; (toggles < I2C_RECOVERY_MAX_TOGGLES) &&
+		(HAL_GPIO_ReadPin(I2C1_SDA_GPIOX, I2C1_SDA_GPIOPIN) == GPIO_PIN_RESET); ++toggles)
 	{
 		HAL_GPIO_TogglePin(I2C1_SCL_GPIOX, I2C1_SCL_GPIOPIN);
 		vTaskDelay(1);
 	}
+	HAL_GPIO_WritePin(I2C1_SCL_GPIOX, I2C1_SCL_GPIOPIN, GPIO_PIN_SET);
 
 	/* Initialize I2C for normal operation.*/
 	MX_I2C1_Init();
@@ -132,17 +139,75 @@ static void I2C2_ResolveStuckSlave(void)
 	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
 	HAL_GPIO_Init(I2C2_SCL_GPIOX, &GPIO_InitStruct);
 
-	/* Generate clock pulses until slave releases the data line */
-	while(HAL_GPIO_ReadPin(I2C2_SDA_GPIOX, I2C2_SDA_GPIOPIN) == GPIO_PIN_RESET)
+	/* Generate clock pulses until slave releases the data line, give up on a shorted bus */
+	HAL_GPIO_WritePin(I2C2_SCL_GPIOX, I2C2_SCL_GPIOPIN, GPIO_PIN_SET);
+	for (unsigned toggles = 0; (toggles < I2C_RECOVERY_MAX_TOGGLES) &&
+		(HAL_GPIO_ReadPin(I2C2_SDA_GPIOX, I2C2_SDA_GPIOPIN) == GPIO_PIN_RESET); ++toggles)
 	{
 		HAL_GPIO_TogglePin(I2C2_SCL_GPIOX, I2C2_SCL_GPIOPIN);
 		vTaskDelay(1);
 	}
+	HAL_GPIO_WritePin(I2C2_SCL_GPIOX, I2C2_SCL_GPIOPIN, GPIO_PIN_SET);
 
 	/* Initialize I2C for normal operation.*/
 	MX_I2C2_Init();
 }
 
+I2C_StatusTypeDef I2C_Recover(I2C_HandleTypeDef *hi2c)
+{
+	if (hi2c->Instance == I2C1)
+	{
+		I2C1_ResolveStuckSlave();
+	}
+	else if (hi2c->Instance == I2C2)
+	{
+		I2C2_ResolveStuckSlave();
+	}
+	else
+	{
+		ASSERT(0);
+		return I2C_ERROR;
+	}
+	return I2C_OK;
+}
+
+void I2C_SetCompletionHandler(I2C_HandleTypeDef *hi2c, I2C_CompletionHandler_t handler)
+{
+	if (hi2c->Instance == I2C1)
+	{
+		I2C1_completion_handler = handler;
+	}
+	else if (hi2c->Instance == I2C2)
+	{
+		I2C2_completion_handler = handler;
+	}
+	else
+	{
+		ASSERT(0);
+	}
+}
+
+/* @return true if the completion has been passed to a registered handler */
+static bool CallCompletionHandler(I2C_HandleTypeDef *hi2c, I2C_StatusTypeDef flag)
+{
+	I2C_CompletionHandler_t handler = NULL;
+	if (hi2c->Instance == I2C1)
+	{
+		handler = I2C1_completion_handler;
+	}
+	else if (hi2c->Instance == I2C2)
+	{
+		handler = I2C2_completion_handler;
+	}
+
+	if (NULL == handler)
+	{
+		return false;
+	}
+	handler(flag);
+	return true;
+}
+
 I2C_StatusTypeDef I2C_Init(I2C_HandleTypeDef *hi2c)
 {
 	I2C_StatusTypeDef status = I2C_OK;
@@ -300,6 +365,11 @@ I2C_StatusTypeDef I2C_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_
 
 void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_OK))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_OK;
@@ -322,6 +392,11 @@ void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
 
 void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_OK))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_OK;
@@ -345,6 +420,11 @@ void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
 
 void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_OK))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_OK;
@@ -368,6 +448,11 @@ void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
 
 void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_OK))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_OK;
@@ -391,6 +476,11 @@ void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
 
 void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_ERROR))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_ERROR;
@@ -414,6 +504,11 @@ void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
 
 void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
 {
+	if (CallCompletionHandler(hi2c, I2C_ERROR))
+	{
+		return;
+	}
+
 	BaseType_t xHigherPriorityTaskWokenByPost = pdFALSE;
 	BaseType_t queue_status;
 	I2C_StatusTypeDef flag = I2C_ERROR;
@@ -37,7 +37,13 @@ typedef enum
   I2C_ERROR    = 0x01U
 } I2C_StatusTypeDef;
 
+/* Called from the I2C interrupt when a transfer has finished.
+ * While a handler is registered the blocking functions below must not be used on this bus. */
+typedef void (*I2C_CompletionHandler_t)(I2C_StatusTypeDef status);
+
 I2C_StatusTypeDef I2C_Init(I2C_HandleTypeDef *hi2c);
+I2C_StatusTypeDef I2C_Recover(I2C_HandleTypeDef *hi2c); /* clock out a stuck slave and re-initialize, task context only */
+void I2C_SetCompletionHandler(I2C_HandleTypeDef *hi2c, I2C_CompletionHandler_t handler); /* NULL: blocking operation */
 I2C_StatusTypeDef I2C_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size);
 I2C_StatusTypeDef I2C_ReadRegister(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
 I2C_StatusTypeDef I2C_WriteRegister(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
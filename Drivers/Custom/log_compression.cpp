@@ -0,0 +1,183 @@
+/** ***********************************************************************
+ * @file		log_compression.cpp
+ * @brief		compressed flight log format: encoder and decoder
+ **************************************************************************/
+
+#include "log_compression.h"
+#include "string.h"
+#include "math.h"
+
+void log_quantization::setup( const log_channel_descriptor_t * channels, unsigned count)
+{
+  for( unsigned word = 0; word < LOG_RECORD_WORDS; ++word)
+    quantum[word] = inverse_quantum[word] = 0.0f;
+
+  for( unsigned i = 0; i < count; ++i)
+    {
+      const log_channel_descriptor_t & channel = channels[i];
+      if( channel.type != LOG_FLOAT32 || channel.quantum == 0.0f)
+	continue;
+      for( unsigned k = 0; k < channel.count; ++k)
+	{
+	  unsigned word = channel.offset / sizeof( uint32_t) + k;
+	  if( word >= LOG_RECORD_WORDS)
+	    break;
+	  quantum[word] = channel.quantum;
+	  inverse_quantum[word] = 1.0f / channel.quantum;
+	}
+    }
+}
+
+static inline uint8_t * put_varint( uint8_t * next, uint32_t value)
+{
+  while( value >= 0x80)
+    {
+      *next++ = (uint8_t)(value | 0x80);
+      value >>= 7;
+    }
+  *next++ = (uint8_t)value;
+  return next;
+}
+
+//! @return 0 if the input is exhausted or the varint is too long
+static inline const uint8_t * get_varint( const uint8_t * next, const uint8_t * end, uint32_t &value)
+{
+  value = 0;
+  for( unsigned shift = 0; shift < 35; shift += 7)
+    {
+      if( next >= end)
+	return 0;
+      uint8_t byte = *next++;
+      value |= (uint32_t)(byte & 0x7f) << shift;
+      if( (byte & 0x80) == 0)
+	return next;
+    }
+  return 0;
+}
+
+static inline uint32_t zigzag( int32_t value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag( uint32_t value)
+{
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+log_block_encoder::log_block_encoder( uint8_t * block_buffer, const log_quantization & quantization)
+  : block( block_buffer), quantization( quantization)
+{
+  start();
+}
+
+void log_block_encoder::start( void)
+{
+  next = block + sizeof( compressed_block_header_t);
+  records = 0;
+  memset( previous, 0, sizeof( previous)); // key frame = delta against zero
+}
+
+bool log_block_encoder::append( const uint32_t * record)
+{
+  uint8_t encoded[LOG_MAX_ENCODED_RECORD];
+  uint8_t * out = encoded;
+  uint32_t current[LOG_RECORD_WORDS];
+
+  if( records == 255)
+    return false;
+
+  for( unsigned i = 0; i < LOG_RECORD_WORDS; ++i)
+    {
+      if( quantization.quantum[i] == 0.0f)
+	{
+	  current[i] = record[i];
+	  out = put_varint( out, current[i] ^ previous[i]);
+	}
+      else
+	{
+	  float value;
+	  memcpy( &value, record + i, sizeof( float));
+	  value *= quantization.inverse_quantum[i];
+	  int32_t q;
+	  if( isnan( value))
+	    q = LOG_QUANTIZED_NAN;
+	  else if( fabsf( value) < (float)LOG_QUANTIZED_LIMIT)
+	    q = (int32_t)floorf( value + 0.5f);
+	  else
+	    q = value > 0.0f ? LOG_QUANTIZED_LIMIT : -LOG_QUANTIZED_LIMIT;
+	  current[i] = (uint32_t)q;
+	  out = put_varint( out, zigzag( (int32_t)(current[i] - previous[i])));
+	}
+    }
+
+  unsigned size = out - encoded;
+  if( next + size > block + LOG_COMPRESSED_BLOCK_SIZE)
+    return false; // block full
+
+  memcpy( next, encoded, size);
+  next += size;
+  memcpy( previous, current, sizeof( previous));
+  ++records;
+  return true;
+}
+
+void log_block_encoder::finish( void)
+{
+  compressed_block_header_t header;
+  header.magic = LOG_COMPRESSION_MAGIC;
+  header.version = LOG_COMPRESSION_VERSION;
+  header.records = records;
+  header.payload_size = (uint16_t)(next - block - sizeof( compressed_block_header_t));
+  header.reserved = 0;
+  memcpy( block, &header, sizeof( header));
+  memset( next, 0, block + LOG_COMPRESSED_BLOCK_SIZE - next);
+}
+
+bool log_block_decoder::start( const uint8_t * block)
+{
+  compressed_block_header_t header;
+  memcpy( &header, block, sizeof( header));
+  records_left = 0;
+
+  if( (header.magic != LOG_COMPRESSION_MAGIC) || (header.version != LOG_COMPRESSION_VERSION)
+      || (header.payload_size > LOG_COMPRESSED_BLOCK_SIZE - sizeof( compressed_block_header_t)))
+    return false;
+
+  next = block + sizeof( compressed_block_header_t);
+  end = next + header.payload_size;
+  records_left = header.records;
+  memset( previous, 0, sizeof( previous));
+  return true;
+}
+
+bool log_block_decoder::decode( uint32_t * record)
+{
+  if( records_left == 0)
+    return false;
+
+  for( unsigned i = 0; i < LOG_RECORD_WORDS; ++i)
+    {
+      uint32_t code;
+      next = get_varint( next, end, code);
+      if( next == 0)
+	{
+	  records_left = 0;
+	  return false;
+	}
+
+      if( quantization->quantum[i] == 0.0f)
+	{
+	  previous[i] ^= code;
+	  record[i] = previous[i];
+	}
+      else
+	{
+	  previous[i] += (uint32_t)unzigzag( code);
+	  float value = (int32_t)previous[i] == LOG_QUANTIZED_NAN ? NAN : (float)(int32_t)previous[i] * quantization->quantum[i];
+	  memcpy( record + i, &value, sizeof( float));
+	}
+    }
+  --records_left;
+  return true;
+}
@@ -0,0 +1,102 @@
+/** ***********************************************************************
+ * @file		log_compression.h
+ * @brief		compressed flight log format (.c50)
+ *
+ * The file is a sequence of LOG_COMPRESSED_BLOCK_SIZE blocks.
+ * Each block starts with a header followed by a key frame and delta frames.
+ * A block can be decoded without any other block.
+ * Every 32-bit word of the record is one channel, coded as
+ * varint( zigzag( delta( quantized value))) or varint( XOR( raw bits)).
+ * The quantization is taken from a channel schema, see log_quantization.
+ * Quantized NaN is coded as LOG_QUANTIZED_NAN, values beyond
+ * +/- LOG_QUANTIZED_LIMIT quanta (including infinity) saturate.
+ **************************************************************************/
+
+#ifndef CUSTOM_LOG_COMPRESSION_H_
+#define CUSTOM_LOG_COMPRESSION_H_
+
+#include "stdint.h"
+#include "log_format.h"
+
+#define LOG_COMPRESSION_MAGIC		0x3543	// "C5" little endian
+#define LOG_COMPRESSION_VERSION		1
+#define LOG_COMPRESSED_BLOCK_SIZE	2048	// bytes
+#define LOG_RECORD_WORDS		50	// sizeof(measurement_data_t)+sizeof(coordinates_t) / 4
+#define LOG_MAX_ENCODED_RECORD		(LOG_RECORD_WORDS * 5) // worst case: 5 bytes per varint
+#define LOG_QUANTIZED_NAN		INT32_MIN	// "no GNSS fix" and other invalid values
+#define LOG_QUANTIZED_LIMIT		2000000000
+
+//! header at the beginning of every compressed block
+typedef struct
+{
+  uint16_t magic;		//!< LOG_COMPRESSION_MAGIC
+  uint8_t version;		//!< LOG_COMPRESSION_VERSION
+  uint8_t records;		//!< number of records within this block
+  uint16_t payload_size;	//!< bytes used behind the header, rest is zero padding
+  uint16_t reserved;
+} compressed_block_header_t;
+
+//! per-word quantization of a record, expanded from a channel table
+class log_quantization
+{
+public:
+  log_quantization( const log_channel_descriptor_t * channels = 0, unsigned count = 0)
+  {
+    setup( channels, count);
+  }
+
+  void setup( const log_channel_descriptor_t * channels, unsigned count);
+
+  float quantum[LOG_RECORD_WORDS];		//!< 0.0f: lossless
+  float inverse_quantum[LOG_RECORD_WORDS];
+};
+
+//! fills one block with records
+class log_block_encoder
+{
+public:
+  log_block_encoder( uint8_t * block_buffer, const log_quantization & quantization);
+
+  //! clear block buffer, next record will be a key frame
+  void start( void);
+
+  //! @return false if the block is full, then finish(), write the block, start() and append again
+  bool append( const uint32_t * record);
+
+  //! complete header and zero-pad the block
+  void finish( void);
+
+  bool is_empty( void) const
+  {
+    return records == 0;
+  }
+private:
+  uint8_t * block;
+  const log_quantization & quantization;
+  uint8_t * next;
+  uint8_t records;
+  uint32_t previous[LOG_RECORD_WORDS];
+};
+
+//! extracts records from one block
+class log_block_decoder
+{
+public:
+  log_block_decoder( const log_quantization & quantization)
+    : quantization( &quantization), next(0), end(0), records_left(0)
+  {}
+
+  //! @return false if this is not a valid compressed block
+  bool start( const uint8_t * block);
+
+  //! @return false if the block is exhausted or corrupted
+  bool decode( uint32_t * record);
+private:
+  const log_quantization * quantization;
+  const uint8_t * next;
+  const uint8_t * end;
+  uint8_t records_left;
+  uint32_t previous[LOG_RECORD_WORDS];
+};
+
+#endif /* CUSTOM_LOG_COMPRESSION_H_ */
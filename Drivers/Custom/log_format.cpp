@@ -0,0 +1,63 @@
+/** ***********************************************************************
+ * @file		log_format.cpp
+ * @brief		flight log channel schema of this firmware
+ **************************************************************************/
+
+#include "system_configuration.h"
+#include "data_structures.h"
+#include "log_format.h"
+#include "log_compression.h"
+#include "stddef.h"
+
+#define M(field)	offsetof( measurement_data_t, field)
+#define C(field)	(sizeof( measurement_data_t) + offsetof( coordinates_t, field))
+
+//! record = measurement_data_t followed by coordinates_t
+const log_channel_descriptor_t log_channels[] =
+{
+    { "acc",				M(acc),				LOG_FLOAT32, 3, 1e-3f },	// m/s^2
+    { "gyro",				M(gyro),			LOG_FLOAT32, 3, 1e-5f },	// rad/s
+    { "mag",				M(mag),				LOG_FLOAT32, 3, 1e-4f },
+    { "static_pressure",		M(static_pressure),		LOG_FLOAT32, 1, 1e-2f },	// Pa
+    { "pitot_pressure",			M(pitot_pressure),		LOG_FLOAT32, 1, 1e-3f },	// Pa
+    { "absolute_pressure",		M(absolute_pressure),		LOG_FLOAT32, 1, 1e-2f },	// Pa
+    { "static_sensor_temp",		M(static_sensor_temperature),	LOG_FLOAT32, 1, 1e-3f },	// degrees C
+    { "absolute_sensor_temp",		M(absolute_sensor_temperature),	LOG_FLOAT32, 1, 1e-3f },
+    { "supply_voltage",			M(supply_voltage),		LOG_FLOAT32, 1, 1e-3f },	// V
+    { "outside_air_temperature",	M(outside_air_temperature),	LOG_FLOAT32, 1, 1e-2f },
+    { "outside_air_humidity",		M(outside_air_humidity),	LOG_FLOAT32, 1, 1e-4f },
+#if WITH_LOWCOST_SENSORS
+    { "lowcost_acc",			M(lowcost_acc),			LOG_FLOAT32, 3, 1e-3f },
+    { "lowcost_gyro",			M(lowcost_gyro),		LOG_FLOAT32, 3, 1e-5f },
+    { "lowcost_mag",			M(lowcost_mag),			LOG_FLOAT32, 3, 1e-4f },
+#endif
+    { "position",			C(position),			LOG_FLOAT32, 3, 1e-3f },	// NED m
+    { "velocity",			C(velocity),			LOG_FLOAT32, 3, 1e-3f },	// NED m/s
+    { "acceleration",			C(acceleration),		LOG_FLOAT32, 3, 1e-3f },	// NED m/s^2
+    { "heading_motion",			C(heading_motion),		LOG_FLOAT32, 1, 1e-3f },	// degrees
+    { "speed_motion",			C(speed_motion),		LOG_FLOAT32, 1, 1e-3f },	// m/s
+    { "relPosNED",			C(relPosNED),			LOG_FLOAT32, 3, 1e-3f },	// m
+    { "relPosHeading",			C(relPosHeading),		LOG_FLOAT32, 1, 1e-4f },
+#if OLD_COORD_FORMAT == 0
+    { "speed_acc",			C(speed_acc),			LOG_FLOAT32, 1, 1e-3f },	// m/s
+#endif
+    { "latitude",			C(latitude),			LOG_FLOAT64, 1, 0.0f },		// degrees
+    { "longitude",			C(longitude),			LOG_FLOAT64, 1, 0.0f },
+    { "year",				C(year),			LOG_UINT8,   1, 0.0f },
+    { "month",				C(month),			LOG_UINT8,   1, 0.0f },
+    { "day",				C(day),				LOG_UINT8,   1, 0.0f },
+    { "hour",				C(hour),			LOG_UINT8,   1, 0.0f },
+    { "minute",				C(minute),			LOG_UINT8,   1, 0.0f },
+    { "second",				C(second),			LOG_UINT8,   1, 0.0f },
+    { "SATS_number",			C(SATS_number),			LOG_UINT8,   1, 0.0f },
+    { "sat_fix_type",			C(sat_fix_type),		LOG_UINT8,   1, 0.0f },
+#if INCLUDING_NANO
+    { "nano",				C(nano),			LOG_INT32,   1, 0.0f },	// ns
+#endif
+    { "geo_sep_dm",			C(geo_sep_dm),			LOG_INT16,   1, 0.0f },	// 0.1 m
+};
+
+const unsigned log_channel_count = sizeof( log_channels) / sizeof( log_channel_descriptor_t);
+
+static_assert( sizeof( measurement_data_t) + sizeof( coordinates_t) == LOG_RECORD_WORDS * sizeof( uint32_t),
+	       "log record layout changed");
@@ -0,0 +1,136 @@
+/** ***********************************************************************
+ * @file		log_format.h
+ * @brief		self-describing flight log: file header and channel schema
+ *
+ * A log file starts with a header block of LOG_HEADER_SIZE bytes:
+ * log_header_t, channel_count * log_channel_descriptor_t,
+ * parameter_count * log_parameter_t, zero padding.
+ * The records (raw or compressed) follow at offset header_size.
+ * A sparse time index for random access is written into a separate file.
+ * File names: *.h50 raw records behind the header, *.c50 compressed.
+ * Legacy *.f50 files hold raw records only, without any header.
+ * Host check: Host_tools/log_reader_check.cpp, Host_tools/log_index_check.cpp
+ **************************************************************************/
+
+#ifndef CUSTOM_LOG_FORMAT_H_
+#define CUSTOM_LOG_FORMAT_H_
+
+#include "stdint.h"
+#include "string.h"
+
+#define LOG_HEADER_MAGIC	0x474f4c4c	// "LLOG" little endian
+#define LOG_HEADER_VERSION	1
+#define LOG_HEADER_SIZE		2048		// one logger block, keeps the records sector-aligned
+#define LOG_CHANNEL_NAME_LENGTH	24
+#define LOG_FIRMWARE_LENGTH	64
+
+enum log_record_format_t { LOG_FORMAT_RAW, LOG_FORMAT_COMPRESSED};
+
+enum log_header_flags_t
+{
+  LOG_PARAMETERS_TRUNCATED = 1	//!< persistent data did not fit completely into the header block
+};
+
+enum log_channel_type_t
+{
+  LOG_FLOAT32, LOG_FLOAT64,
+  LOG_INT8, LOG_UINT8,
+  LOG_INT16, LOG_UINT16,
+  LOG_INT32, LOG_UINT32
+};
+
+//! first part of the header block
+typedef struct
+{
+  uint32_t magic;		//!< LOG_HEADER_MAGIC
+  uint16_t version;		//!< LOG_HEADER_VERSION
+  uint16_t header_size;		//!< file offset of the first record or block
+  uint16_t record_size;		//!< bytes per (uncompressed) record
+  uint16_t sample_rate;		//!< records per second
+  uint8_t format;		//!< log_record_format_t
+  uint8_t channel_count;	//!< number of channel descriptors
+  uint8_t parameter_count;	//!< number of persistent parameters
+  uint8_t flags;		//!< log_header_flags_t
+  uint32_t unique_id[4];	//!< CPU serial number
+  char firmware[LOG_FIRMWARE_LENGTH]; //!< GIT_TAG_INFO, zero terminated
+} log_header_t;
+
+//! one channel = "count" consecutive values of "type" within the record
+typedef struct
+{
+  char name[LOG_CHANNEL_NAME_LENGTH];	//!< zero terminated
+  uint16_t offset;	//!< byte offset within the record
+  uint8_t type;		//!< log_channel_type_t
+  uint8_t count;	//!< number of elements, 3 for vectors
+  float quantum;	//!< resolution in compressed files, 0.0f = lossless
+} log_channel_descriptor_t;
+
+//! persistent data (EEPROM) snapshot entry
+typedef struct
+{
+  uint16_t id;		//!< EEPROM_PARAMETER_ID
+  uint16_t reserved;
+  char mnemonic[16];	//!< zero terminated
+  float value;
+} log_parameter_t;
+
+#define LOG_INDEX_MAGIC		0x58444955	// "UIDX" little endian
+#define LOG_INDEX_VERSION	2
+
+//! head of the index file <logfile>.IDX, followed by log_index_entry_t entries
+typedef struct
+{
+  uint32_t magic;		//!< LOG_INDEX_MAGIC
+  uint16_t version;		//!< LOG_INDEX_VERSION
+  uint16_t entry_size;		//!< sizeof( log_index_entry_t)
+  uint32_t data_size;		//!< valid bytes of the log file as of the last sync, the rest is preallocated
+} log_index_header_t;
+
+//! sparse time index, entries sorted by time
+typedef struct
+{
+  uint32_t day_time_ms;		//!< GNSS (UTC) time of day of the record
+  uint32_t record;		//!< record number, 0 = first record
+  uint32_t offset;		//!< file offset: raw record or compressed block starting with this record
+} log_index_entry_t;
+
+//! record layout of this firmware
+extern const log_channel_descriptor_t log_channels[];
+extern const unsigned log_channel_count;
+
+//! @return first element of the channel table behind the header
+inline const log_channel_descriptor_t * get_log_channels( const log_header_t * header)
+{
+  return (const log_channel_descriptor_t *)(header + 1);
+}
+
+//! @return first element of the parameter snapshot behind the channel table
+inline const log_parameter_t * get_log_parameters( const log_header_t * header)
+{
+  return (const log_parameter_t *)(get_log_channels( header) + header->channel_count);
+}
+
+//! @return header if the block is a valid log header, 0 for legacy files without header
+inline const log_header_t * get_log_header( const void * block)
+{
+  const log_header_t * header = (const log_header_t *)block;
+  if( header->magic != LOG_HEADER_MAGIC || header->version != LOG_HEADER_VERSION)
+    return 0;
+  if( sizeof( log_header_t)
+      + header->channel_count * sizeof( log_channel_descriptor_t)
+      + header->parameter_count * sizeof( log_parameter_t) > header->header_size)
+    return 0; // corrupted
+  return header;
+}
+
+//! @return channel descriptor for name or 0 if not present in this file
+inline const log_channel_descriptor_t * find_log_channel( const log_header_t * header, const char * name)
+{
+  const log_channel_descriptor_t * channel = get_log_channels( header);
+  for( unsigned i = 0; i < header->channel_count; ++i, ++channel)
+    if( strncmp( channel->name, name, LOG_CHANNEL_NAME_LENGTH) == 0)
+      return channel;
+  return 0;
+}
+
+#endif /* CUSTOM_LOG_FORMAT_H_ */
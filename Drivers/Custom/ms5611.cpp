@@ -149,43 +149,44 @@ inline void MS5611::calibrate (const uint32_t d1, const uint32_t d2)
 	  pressure_octapascal = pressure_raw;
 }
 
-bool MS5611::update (void)
+void MS5611::schedule (I2C_scheduler &bus)
 {
-	uint32_t tmp;
-	unsigned errorcount = 0;
+	// temperature changes slowly: mostly pressure conversions
+	next_temperature = conversion_counter + 1 >= MS5611_TEMPERATURE_DECIMATION;
+	conversion_command = CMD_ADC_CONV | (next_temperature ? CMD_ADC_D2 : CMD_ADC_D1) | CMD_ADC_4096;
+
+	read_ADC = { &device, I2C_TRANSFER_READ_REGISTER, CMD_ADC_READ, ADC_data, 3, I2C_ERROR};
+	start_conversion = { &device, I2C_TRANSFER_WRITE, 0, &conversion_command, 1, I2C_ERROR};
+	bus.add (read_ADC);
+	bus.add (start_conversion);
+}
+
+bool MS5611::evaluate (void)
+{
+	new_pressure = false;
 
-	if (measure_temperature)
+	// the ADC reads 0 if there was no conversion
+	uint32_t tmp = (ADC_data[0] << 16) | (ADC_data[1] << 8) | ADC_data[2];
+	if ((read_ADC.status == I2C_OK) && (tmp != 0))
 	{
-		do
-		  {
-			tmp = read_24_bits ();
-			++errorcount;
-			if( errorcount > 4)
-			  return false;
-		  }
-		while( tmp == 0xffffffff);
-
-		ADC_temperature_reading = tmp;
-		start_pressure_conversion ();
-		measure_temperature = false;
+		if (measure_temperature)
+			ADC_temperature_reading = tmp;
+		else
+		{
+			ADC_pressure_reading = tmp;
+			calibrate (ADC_pressure_reading, ADC_temperature_reading);
+			new_pressure = true;
+		}
 	}
-	else
+
+	if (start_conversion.status == I2C_OK)
 	{
-		do
-		  {
-			tmp = read_24_bits ();
-			++errorcount;
-			if( errorcount > 4)
-			  return false;
-		  }
-		while( tmp == 0xffffffff);
-
-		ADC_pressure_reading = tmp;
-		start_temperature_conversion ();
-		measure_temperature = true;
-		calibrate (ADC_pressure_reading, ADC_temperature_reading);
+		measure_temperature = next_temperature;
+		if (++conversion_counter >= MS5611_TEMPERATURE_DECIMATION)
+			conversion_counter = 0;
 	}
-	return true;
+
+	return device.consecutive_errors < I2C_MAX_CONSECUTIVE_ERRORS;
 }
 
 inline uint16_t MS5611::read_coef (uint8_t coef_num)
@@ -2,17 +2,31 @@
 #define MS5611_DRIVER_H
 
 #include <i2c.h>
+#include "I2C_scheduler.h"
 #define MS5611_I2C &hi2c2
+#define MS5611_SCHEDULER I2C2_scheduler
+
+#define MS5611_TEMPERATURE_DECIMATION	10 // one temperature conversion per 10 conversions
+#define MS5611_CONVERSION_TIME_USEC	9040 // OSR 4096, maximum
+#define MS5611_TRANSFER_TIME_USEC	250 // ADC read + conversion start @ 400 kHz, the conversion starts this late in the batch
 
 class MS5611
 {
 public:
-  inline MS5611(uint8_t i2c_address)
+  inline MS5611(uint8_t i2c_address, uint8_t bus_priority)
+  : device( i2c_address, bus_priority)
   {
 	  I2C_address = i2c_address;
+	  conversion_counter = 0;
+	  new_pressure = false;
   }
   bool initialize(void);
-  bool update( void);
+  void schedule( I2C_scheduler &bus); //!< queue: read the finished conversion and start the next one
+  bool evaluate( void); //!< after the batch, @return false if the sensor needs a re-initialization
+  inline bool pressure_updated( void) const //!< latest evaluate() has delivered a pressure
+  {
+    return new_pressure;
+  }
   inline float get_pressure( void) const //!< getter function
   {
     return pressure_octapascal * 0.125f;
@@ -42,7 +56,16 @@ private:
   int32_t  pressure_octapascal; 	//!< absolute pressure in 1/8 Pascal
   int32_t  temperature_celsius;		//!< sensor temperature in 1/100 Degrees Celsius
   uint16_t PromData[8]; 		//!< coefficients table for pressure sensor PROM values
-  bool measure_temperature;	//!< Measurement cycle flip-flop
+  bool measure_temperature;	//!< temperature conversion running
+  bool new_pressure;
+  bool next_temperature;	//!< scheduled conversion is a temperature conversion
+  uint8_t conversion_counter;	//!< pressure conversions since the last temperature conversion
+
+  I2C_device_t device;
+  uint8_t ADC_data[3];
+  uint8_t conversion_command;
+  I2C_transaction_t read_ADC;
+  I2C_transaction_t start_conversion;
 };
 
 #endif /* MS5611_01BA01_H_ */
@@ -0,0 +1,67 @@
+/** ***********************************************************************
+ * @file		pressure_prefilter.cpp
+ * @brief		spike rejection and low-pass filter for raw barometric pressure
+ **************************************************************************/
+
+#include "pressure_prefilter.h"
+
+//! bilinear transform of the analog Butterworth, DC gain 1
+static constexpr biquad_coefficients_t biquad_bank[PRESSURE_BIQUAD_SECTIONS] =
+{
+    { 1.31106440e-01f, 2.62212880e-01f, 1.31106440e-01f, -7.47789178e-01f, 2.72214938e-01f}
+};
+
+float pressure_prefilter::median( float deviation)
+{
+  window[position] = deviation;
+  if( ++position >= PRESSURE_MEDIAN_LENGTH)
+    position = 0;
+
+  // insertion sort, N is tiny
+  float sorted[PRESSURE_MEDIAN_LENGTH];
+  for( unsigned i = 0; i < PRESSURE_MEDIAN_LENGTH; ++i)
+    {
+      float value = window[i];
+      unsigned k = i;
+      for( ; k > 0 && sorted[k - 1] > value; --k)
+	sorted[k] = sorted[k - 1];
+      sorted[k] = value;
+    }
+  return sorted[PRESSURE_MEDIAN_LENGTH / 2];
+}
+
+float pressure_prefilter::feed( float pressure)
+{
+  if( ! valid)
+    {
+      // start in steady state: no transient from zero
+      offset = pressure;
+      for( unsigned i = 0; i < PRESSURE_MEDIAN_LENGTH; ++i)
+	window[i] = 0.0f;
+      position = 0;
+      latest_median = 0.0f;
+      for( unsigned s = 0; s < PRESSURE_BIQUAD_SECTIONS; ++s)
+	state[s][0] = state[s][1] = 0.0f;
+      valid = true;
+    }
+
+  float x = median( pressure - offset);
+  latest_median = x;
+
+  for( unsigned s = 0; s < PRESSURE_BIQUAD_SECTIONS; ++s)
+    {
+      const biquad_coefficients_t & c = biquad_bank[s];
+      float y = c.b0 * x + state[s][0];
+      state[s][0] = c.b1 * x - c.a1 * y + state[s][1];
+      state[s][1] = c.b2 * x - c.a2 * y;
+      x = y;
+    }
+
+  return offset + x;
+}
+
+void pressure_prefilter::hold( void)
+{
+  if( valid)
+    (void)feed( offset + latest_median); // a spike in the latest reading would be doubled
+}
@@ -0,0 +1,64 @@
+/** ***********************************************************************
+ * @file		pressure_prefilter.h
+ * @brief		spike rejection and low-pass filter for raw barometric pressure
+ *
+ * Every new pressure reading passes a median-of-N spike rejector and a
+ * cascade of biquad sections (direct form II transposed) at the raw
+ * sensor rate. The filter works on the deviation from the first sample
+ * so that the float states keep their resolution at 100 kPa.
+ * The default section is a 2nd order Butterworth low-pass,
+ * 15 Hz cut-off @ 100 Hz, -12 dB at 25 Hz, -44 dB at 45 Hz.
+ * Its group delay at low frequencies is 1.39 samples,
+ * the median adds (N-1)/2 samples on steps and ramps.
+ * Host check: Host_tools/pressure_prefilter_check.cpp
+ **************************************************************************/
+
+#ifndef CUSTOM_PRESSURE_PREFILTER_H_
+#define CUSTOM_PRESSURE_PREFILTER_H_
+
+#include "stdint.h"
+
+#define PRESSURE_MEDIAN_LENGTH		3 // odd, 1 = no spike rejection
+
+#define PRESSURE_BIQUAD_SECTIONS	1
+#define PRESSURE_BIQUAD_DELAY		1.39f // samples, all sections at DC
+
+//! coefficients of H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+typedef struct
+{
+  float b0, b1, b2, a1, a2;
+} biquad_coefficients_t;
+
+class pressure_prefilter
+{
+  static_assert( PRESSURE_MEDIAN_LENGTH % 2 == 1 && PRESSURE_MEDIAN_LENGTH <= 7,
+		 "median length must be odd and not larger than 7");
+public:
+  pressure_prefilter( void)
+  {
+    reset();
+  }
+
+  void reset( void)
+  {
+    valid = false;
+  }
+
+  //! feed one raw reading, @return filtered pressure
+  float feed( float pressure);
+
+  //! no reading at this sample time: repeat the latest median output, nothing before the first reading
+  void hold( void);
+
+private:
+  float median( float deviation);
+
+  float offset;					//!< first sample, filter input is relative
+  float window[PRESSURE_MEDIAN_LENGTH];		//!< latest readings, ring buffer
+  unsigned position;
+  float latest_median;				//!< repeated by hold()
+  float state[PRESSURE_BIQUAD_SECTIONS][2];	//!< s1, s2 per section
+  bool valid;
+};
+
+#endif /* CUSTOM_PRESSURE_PREFILTER_H_ */
@@ -17,6 +17,7 @@ extern DMA_HandleTypeDef hdma_spi2_rx;
 extern DMA_HandleTypeDef hdma_spi2_tx;
 COMMON  static TaskHandle_t SPI1_task_Id = NULL;
 COMMON  static TaskHandle_t SPI2_task_Id = NULL;
+COMMON  static void (*SPI1_completion_handler)(void) = NULL;
 
 static inline void register_SPI_usertask(SPI_HandleTypeDef *hspi)
 {
@@ -61,12 +62,23 @@ void SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, uint3
 }
 
 
+void SPI_set_completion_handler(SPI_HandleTypeDef *hspi, void (*handler)(void))
+{
+	ASSERT( hspi->Instance == SPI1);
+	SPI1_completion_handler = handler;
+}
+
 void HAL_SPI_CpltCallback(SPI_HandleTypeDef *hspi)
 {
 	BaseType_t HigherPriorityTaskWoken=0;
 
 	if (hspi->Instance == SPI1)
 	{
+		if( SPI1_completion_handler)
+		{
+			SPI1_completion_handler(); // non-blocking user, no task waiting
+			return;
+		}
 		ASSERT( SPI1_task_Id);
 		vTaskNotifyGiveFromISR( SPI1_task_Id, &HigherPriorityTaskWoken);
 	}
@@ -21,6 +21,9 @@ void SPI_Transceive(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData,
 void SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint16_t Size,  uint32_t timeout=0);
 void SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, uint32_t timeout=0);
 
+//! completion handler called from ISR instead of notifying the task, SPI1 only, NULL to restore
+void SPI_set_completion_handler(SPI_HandleTypeDef *hspi, void (*handler)(void));
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,10 @@
 static COMMON QueueHandle_t UART6_CPL_Message_Id = NULL;
 static COMMON QueueHandle_t UART6_Rx_Queue = NULL;
 
+static COMMON void (*USART1_transmit_complete)(void) = NULL;
+static COMMON void (*USART2_transmit_complete)(void) = NULL;
+static COMMON void (*USART6_transmit_complete)(void) = NULL;
+
 static uint8_t uart6_rx_byte = 0; //
 void UART6_Init(void)
 {
@@ -51,6 +55,24 @@ void UART6_Transmit(const uint8_t *pData, uint16_t Size)
   ASSERT(pdTRUE == queue_status);
 }
 
+bool UART6_Transmit_IT(const uint8_t *pData, uint16_t Size)
+{
+  ASSERT( USART6_transmit_complete); // otherwise the completion would be queued for UART6_Transmit
+  return HAL_UART_Transmit_IT(&huart6, (uint8_t *)pData, Size) == HAL_OK;
+}
+
+void UART_set_transmit_complete_handler(UART_HandleTypeDef *huart, void (*handler)(void))
+{
+  if (huart->Instance == USART1)
+    USART1_transmit_complete = handler;
+  else if (huart->Instance == USART2)
+    USART2_transmit_complete = handler;
+  else if (huart->Instance == USART6)
+    USART6_transmit_complete = handler;
+  else
+    ASSERT(0);
+}
+
 bool UART6_Receive(uint8_t *pRxByte, uint32_t timeout)
 {
   BaseType_t queue_status = pdFALSE;
@@ -73,8 +95,23 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 
   if (huart->Instance == USART6)
     {
-      queue_status = xQueueSendFromISR(UART6_CPL_Message_Id, 0, &xHigherPriorityTaskWokenByPost);
-      ASSERT(pdTRUE == queue_status);
+      if (USART6_transmit_complete)
+	USART6_transmit_complete();
+      else
+	{
+	  queue_status = xQueueSendFromISR(UART6_CPL_Message_Id, 0, &xHigherPriorityTaskWokenByPost);
+	  ASSERT(pdTRUE == queue_status);
+	}
+    }
+  else if (huart->Instance == USART1)
+    {
+      if (USART1_transmit_complete)
+	USART1_transmit_complete();
+    }
+  else if (huart->Instance == USART2)
+    {
+      if (USART2_transmit_complete)
+	USART2_transmit_complete();
     }
   else
     {
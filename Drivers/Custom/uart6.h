@@ -18,6 +18,9 @@ void UART6_Init(void);
 void UART6_DeInit(void);
 void UART6_ChangeBaudRate(uint32_t rate);
 void UART6_Transmit(const uint8_t *pData, uint16_t Size);
+bool UART6_Transmit_IT(const uint8_t *pData, uint16_t Size); // completion handler required
+//! non-blocking transmission: handler called from ISR, USART1, USART2 and USART6 only, NULL to restore
+void UART_set_transmit_complete_handler(UART_HandleTypeDef *huart, void (*handler)(void));
 bool UART6_Receive(uint8_t *pRxByte, uint32_t timeout);
 extern UART_HandleTypeDef huart6;
 
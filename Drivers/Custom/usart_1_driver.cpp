@@ -69,9 +69,9 @@ void USART_1_Init (void)
     }
 }
 
-void USART_1_transmit_DMA( uint8_t *pData, uint16_t Size)
+bool USART_1_transmit_DMA( uint8_t *pData, uint16_t Size)
 {
-  HAL_UART_Transmit_DMA (&huart1, pData, Size);
+  return HAL_UART_Transmit_DMA (&huart1, pData, Size) == HAL_OK;
 }
 
 /**
@@ -9,6 +9,6 @@
 #define CUSTOM_USART_1_DRIVER_H_
 
 void USART_1_Init (void);
-void USART_1_transmit_DMA( uint8_t *pData, uint16_t Size);
+bool USART_1_transmit_DMA( uint8_t *pData, uint16_t Size);
 
 #endif /* CUSTOM_USART_1_DRIVER_H_ */
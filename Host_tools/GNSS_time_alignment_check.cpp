@@ -0,0 +1,95 @@
+/** ***********************************************************************
+ * @file		GNSS_time_alignment_check.cpp
+ * @brief		host check: GNSS epoch time on the CPU time base
+ *
+ * Simulated 10 Hz receiver for two hours: CPU clock running 60 ppm fast or
+ * slow, transport delay = output latency + random jitter (exponential,
+ * 8 ms mean, up to 80 ms), a GPS week rollover and a receiver restart
+ * shifting the clock offset by 3 s.
+ * The measurement time returned must hit the true epoch time on the CPU
+ * clock within a quarter IMU period, apart from a few epochs after the two
+ * steps. The envelope rises by GNSS_CLOCK_DRIFT_PPM between low-jitter
+ * epochs, which causes the remaining error of 1 .. 2 ms.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom GNSS_time_alignment_check.cpp ../Drivers/Custom/GNSS_time_alignment.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "GNSS_time_alignment.h"
+#include <stdio.h>
+#include <math.h>
+
+#define OUTPUT_LATENCY_USEC	25000
+#define EPOCH_MS		100
+#define WEEK_MS			(7U * 24 * 3600 * 1000)
+#define EPOCHS			(2 * 3600 * 1000 / EPOCH_MS)
+#define SETTLING_EPOCHS		50
+#define MAX_ERROR_USEC		2500
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+//! uniform in (0, 1)
+static double random_uniform( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return ((random_state * 0x2545f4914f6cdd1dULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static unsigned run( double drift_ppm)
+{
+  GNSS_time_alignment alignment( OUTPUT_LATENCY_USEC);
+  unsigned failures = 0;
+  unsigned outliers = 0;
+  double worst = 0.0;
+
+  uint32_t iTOW_ms = WEEK_MS - 3600 * 1000; // rollover after one hour
+  double cpu_offset_usec = 123456789.0;     // CPU time at iTOW 0 of this week
+  unsigned last_step = 0;
+  for( unsigned n = 0; n < EPOCHS; ++n)
+    {
+      if( n == EPOCHS * 3 / 4) // receiver restart, clock offset jumps
+	{
+	  cpu_offset_usec += 3e6;
+	  last_step = n;
+	}
+
+      double gps_time_usec = (double)n * EPOCH_MS * 1000.0;
+      double true_cpu_time = cpu_offset_usec + gps_time_usec * (1.0 + drift_ppm * 1e-6);
+      double jitter = fmin( -8000.0 * log( random_uniform()), 80000.0);
+      uint64_t receive_time = (uint64_t)(true_cpu_time + OUTPUT_LATENCY_USEC + jitter);
+
+      uint32_t iTOW = (iTOW_ms + n * EPOCH_MS) % WEEK_MS;
+      if( iTOW == 0) // week rollover, CPU clock continues
+	last_step = n;
+
+      double error = (double)alignment.update( receive_time, iTOW) - true_cpu_time;
+      if( n < SETTLING_EPOCHS || n - last_step < SETTLING_EPOCHS)
+	continue;
+      worst = fmax( worst, fabs( error));
+      if( fabs( error) > MAX_ERROR_USEC)
+	++outliers;
+    }
+
+  if( outliers > 0)
+    {
+      printf( "drift %+.0f ppm: %u epochs off by more than %u us\n", drift_ppm, outliers, MAX_ERROR_USEC);
+      ++failures;
+    }
+  if( alignment.realignments != 2)
+    {
+      printf( "drift %+.0f ppm: %u realignments instead of 2\n", drift_ppm, alignment.realignments);
+      ++failures;
+    }
+  printf( "drift %+.0f ppm: worst error %.0f us, max latency %.1f ms\n", drift_ppm, worst, alignment.max_latency * 1e-3);
+  return failures;
+}
+
+int main( void)
+{
+  unsigned failures = run( 60.0) + run( -60.0) + run( 0.0);
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/** ***********************************************************************
+ * @file		I2C_timing_check.cpp
+ * @brief		host check: I2C sensor cycle timing, MS5611 conversion gate
+ *
+ * Simulates one hour of the i2c_sensors task: IMU tick @ 100 Hz with
+ * jitter, task wake-up delays (mostly short, sometimes up to 1.5 ms),
+ * IMU outages covered by the task's own timeout. Per cycle the transfers
+ * run on both buses at 400 kHz in priority order, as the I2C scheduler
+ * queues them, the MS5611 pair logic mirrors MS5611::schedule () and
+ * MS5611::evaluate ().
+ * Both MS5611 are modelled with the maximum conversion time: an ADC read
+ * must never hit an unfinished conversion, that would return 0 and lose it.
+ * Reported: pressure rate, age of the pressure at publishing time,
+ * skipped conversions and the batch duration per bus.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 I2C_timing_check.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#define MS5611_TEMPERATURE_DECIMATION	10	// as ms5611.h
+#define MS5611_CONVERSION_TIME_USEC	9040	// as ms5611.h
+#define MS5611_TRANSFER_TIME_USEC	250	// as ms5611.h
+#define I2C_SENSORS_TIMEOUT_USEC	20000	// as i2c_sensors.cpp
+#define I2C_BATCH_TIMEOUT_USEC		5000	// as I2C_scheduler.h
+#define FXOS8700_DATA_SIZE		13	// as fxos8700cq.h
+
+#define IMU_PERIOD_USEC		10000
+#define SIMULATED_USEC		(3600ULL * 1000000)
+#define BIT_USEC		2.5	// 400 kHz
+#define INTERRUPT_USEC		8.0	// completion interrupt starting the next transfer
+#define MIN_PRESSURE_RATE	85.0	// Hz, 9 of 10 conversions deliver pressure
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+//! uniform in (0, 1)
+static double random_uniform( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return ((random_state * 0x2545f4914f6cdd1dULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+//! bus time of one transaction: address bytes, register byte, data, start / repeated start / stop
+static double transfer_usec( bool register_access, unsigned bytes)
+{
+  unsigned bits = 9 + 9 * bytes + 2;
+  if( register_access)
+    bits += 9 + 9 + 1;
+  return bits * BIT_USEC + INTERRUPT_USEC;
+}
+
+//! MS5611 as seen on the bus plus the driver state of class MS5611
+struct ms5611_model
+{
+  // sensor
+  double command_time = -1e9;	//!< end of the latest conversion command
+  bool converting = false;
+  // driver
+  unsigned conversion_counter = 0;
+  bool measure_temperature = true;
+  bool next_temperature = false;
+
+  unsigned pressures = 0;
+  unsigned lost = 0;		//!< ADC read before the end of the conversion
+
+  //! @return end of the two transfers, sets new_pressure as evaluate() does
+  double cycle( double bus_time, bool & new_pressure)
+  {
+    // schedule ()
+    next_temperature = conversion_counter + 1 >= MS5611_TEMPERATURE_DECIMATION;
+
+    // read_ADC
+    bool finished = converting && bus_time - command_time >= MS5611_CONVERSION_TIME_USEC;
+    if( converting && ! finished)
+      ++lost;
+    bus_time += transfer_usec( true, 3);
+    // start_conversion
+    bus_time += transfer_usec( false, 1);
+    command_time = bus_time;
+    converting = true;
+
+    // evaluate ()
+    new_pressure = finished && ! measure_temperature;
+    if( new_pressure)
+      ++pressures;
+    measure_temperature = next_temperature;
+    if( ++conversion_counter >= MS5611_TEMPERATURE_DECIMATION)
+      conversion_counter = 0;
+    return bus_time;
+  }
+};
+
+static unsigned failures;
+
+static void expect( bool condition, const char * what, double value)
+{
+  if( condition)
+    return;
+  printf( "%s (%g)\n", what, value);
+  ++failures;
+}
+
+int main( void)
+{
+  ms5611_model ms5611_static, ms5611_pitot;
+
+  double next_tick = IMU_PERIOD_USEC;
+  double wait_start = 0.0;
+  double conversion_start = 0.0;
+  unsigned cycles = 0, skipped = 0, timeouts = 0;
+  double age_sum = 0.0, age_max = 0.0;
+  unsigned ages = 0;
+  double batch_max[2] = { 0.0, 0.0};
+
+  while( next_tick < SIMULATED_USEC)
+    {
+      // notify_take () with timeout
+      double wake;
+      if( next_tick - wait_start > I2C_SENSORS_TIMEOUT_USEC)
+	{
+	  wake = wait_start + I2C_SENSORS_TIMEOUT_USEC;
+	  ++timeouts;
+	}
+      else
+	{
+	  double delay = -30.0 * log( random_uniform());
+	  if( random_uniform() < 0.02) // higher priority task running
+	    delay += 1500.0 * random_uniform();
+	  wake = fmax( next_tick, wait_start) + delay;
+	  double jitter = 200.0 * (random_uniform() - 0.5);
+	  next_tick += IMU_PERIOD_USEC + jitter;
+	  if( random_uniform() < 1e-4) // IMU restart: no ticks for 200 ms
+	    next_tick += 200000.0;
+	}
+      ++cycles;
+
+      // i2c_sensors.cpp: the gate for the MS5611 transfers
+      double batch_start = wake;
+      bool conversion_ready = batch_start - conversion_start >= MS5611_CONVERSION_TIME_USEC + MS5611_TRANSFER_TIME_USEC;
+
+      // I2C2: static (priority 0), pitot (priority 1)
+      double bus_time = batch_start;
+      if( conversion_ready)
+	{
+	  bool static_updated, pitot_updated;
+	  double converted = ms5611_static.command_time + 0.5 * MS5611_CONVERSION_TIME_USEC;
+	  bus_time = ms5611_static.cycle( bus_time, static_updated);
+	  bus_time = ms5611_pitot.cycle( bus_time, pitot_updated);
+	  if( static_updated)
+	    {
+	      // age: middle of the conversion to the publication after the batch
+	      double age = bus_time - converted;
+	      age_sum += age;
+	      age_max = fmax( age_max, age);
+	      ++ages;
+	    }
+	  conversion_start = batch_start;
+	}
+      else
+	++skipped;
+      batch_max[1] = fmax( batch_max[1], bus_time - batch_start);
+
+      // I2C1: HCLA (priority 0), FXOS8700 (priority 1)
+      double bus1_time = batch_start + transfer_usec( false, 2) + transfer_usec( true, FXOS8700_DATA_SIZE);
+      batch_max[0] = fmax( batch_max[0], bus1_time - batch_start);
+
+      wait_start = fmax( bus_time, bus1_time);
+    }
+
+  double seconds = SIMULATED_USEC * 1e-6;
+  double rate = fmin( ms5611_static.pressures, ms5611_pitot.pressures) / seconds;
+  printf( "%u cycles, %u without MS5611 transfers, %u timeouts\n", cycles, skipped, timeouts);
+  printf( "pressure rate %.2f Hz, age mean %.2f ms max %.2f ms\n", rate, age_sum / ages * 1e-3, age_max * 1e-3);
+  printf( "batch I2C1 %.0f us, I2C2 %.0f us\n", batch_max[0], batch_max[1]);
+
+  expect( ms5611_static.lost + ms5611_pitot.lost == 0, "ADC read before the end of the conversion",
+	  ms5611_static.lost + ms5611_pitot.lost);
+  expect( rate > MIN_PRESSURE_RATE, "pressure rate too low", rate);
+  expect( batch_max[0] < I2C_BATCH_TIMEOUT_USEC && batch_max[1] < I2C_BATCH_TIMEOUT_USEC,
+	  "batch exceeds the scheduler timeout", fmax( batch_max[0], batch_max[1]));
+
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/** ***********************************************************************
+ * @file		IMU_decimator_check.cpp
+ * @brief		host check: IMU decimator delay, stop band and magnetometer alignment
+ *
+ * For 400 Hz and 200 Hz input:
+ * - group_delay_usec () matches the FIR of the instance,
+ * - a 2 Hz sine leaves the filter delayed by exactly the group delay,
+ * - 50 .. fs/2 Hz sines are suppressed by more than 62 dB,
+ * - a 100 Hz magnetometer, at any phase to the output, is delayed alike.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom IMU_decimator_check.cpp ../Drivers/Custom/IMU_decimator.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "IMU_decimator.h"
+#include <stdio.h>
+#include <math.h>
+
+static unsigned failures;
+
+static void expect( bool condition, const char * what, unsigned factor, double value)
+{
+  if( condition)
+    return;
+  printf( "factor %u: %s (%g)\n", factor, what, value);
+  ++failures;
+}
+
+//! @return worst deviation of the output from the input sine delayed by the group delay
+static double sine_response( unsigned factor, double frequency, unsigned mag_phase, double * worst_mag)
+{
+  const double T = 1.0 / (100 * factor);
+  IMU_decimator decimator( factor, T);
+  const double delay = decimator.group_delay();
+  const double omega = 2.0 * M_PI * frequency;
+
+  double worst = 0.0;
+  *worst_mag = 0.0;
+  for( unsigned n = 0; n < 400 * factor; ++n)
+    {
+      float x = (float)sin( omega * n * T);
+      float acc[3] = { x, 0.0f, 0.0f}, gyro[3] = { 0.0f, x, 0.0f};
+      if( n % factor == mag_phase)
+	{
+	  float mag[3] = { 0.0f, 0.0f, x};
+	  decimator.feed_mag( mag);
+	}
+      if( ! decimator.feed( acc, gyro) || n < 200 * factor) // settled
+	continue;
+      double expected = sin( omega * (n * T - delay));
+      worst = fmax( worst, fabs( decimator.acc[0] - expected));
+      worst = fmax( worst, fabs( decimator.gyro[1] - expected));
+      *worst_mag = fmax( *worst_mag, fabs( decimator.mag[2] - expected));
+    }
+  return worst;
+}
+
+static void check( unsigned factor)
+{
+  IMU_decimator decimator( factor, 1.0f / (100 * factor));
+  expect( fabs( decimator.group_delay() * 1e6 - IMU_decimator::group_delay_usec( factor)) < 1.0,
+	  "group_delay_usec () differs from the filter", factor, decimator.group_delay() * 1e6);
+
+  double worst_mag;
+  for( unsigned phase = 0; phase < factor; ++phase)
+    {
+      double worst = sine_response( factor, 2.0, phase, &worst_mag);
+      expect( worst < 0.005, "2 Hz sine not delayed by the group delay", factor, worst);
+      expect( worst_mag < 0.005, "magnetometer not delayed by the group delay", factor, worst_mag);
+    }
+
+  double worst_stop = 0.0;
+  for( double frequency = 50.0; frequency < 50.0 * factor; frequency += 2.5)
+    {
+      const double T = 1.0 / (100 * factor);
+      IMU_decimator filter( factor, T);
+      double peak = 0.0;
+      for( unsigned n = 0; n < 400 * factor; ++n)
+	{
+	  float x = (float)sin( 2.0 * M_PI * frequency * n * T);
+	  float acc[3] = { x, 0.0f, 0.0f}, gyro[3] = { 0.0f, 0.0f, 0.0f};
+	  if( filter.feed( acc, gyro) && n >= 200 * factor)
+	    peak = fmax( peak, fabs( filter.acc[0]));
+	}
+      worst_stop = fmax( worst_stop, peak);
+    }
+  expect( 20.0 * log10( worst_stop) < -62.0, "stop band above -62 dB", factor, 20.0 * log10( worst_stop));
+  printf( "factor %u: delay %.2f ms, stop band %.1f dB\n", factor, decimator.group_delay() * 1e3, 20.0 * log10( worst_stop));
+}
+
+int main( void)
+{
+  check( 4);
+  check( 2);
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
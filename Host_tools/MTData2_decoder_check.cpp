@@ -0,0 +1,138 @@
+/** ***********************************************************************
+ * @file		MTData2_decoder_check.cpp
+ * @brief		host check: MTData2 decoder on known messages
+ *
+ * Hand-encoded Xbus messages with exactly representable values:
+ * - the packets of the MTi configuration used by the firmware,
+ * - packets to be skipped: unknown IDs, double precision, a known ID with
+ *   a wrong size; NED coordinate bits are decoded like ENU,
+ * - an extended length message (> 254 byte payload),
+ * - messages to be rejected: other MID, truncated, packet past the end.
+ * The checksums of the literal messages are verified first.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../xSense MTData2_decoder_check.cpp ../xSense/MTData2_decoder.cpp ../xSense/xbushelpers.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "MTData2_decoder.h"
+#include "xbushelpers.h"
+#include "xbusmessageid.h"
+#include <stdio.h>
+#include <string.h>
+
+static unsigned failures;
+
+static void expect( bool condition, const char * what)
+{
+  if( condition)
+    return;
+  printf( "%s\n", what);
+  ++failures;
+}
+
+static bool equal( const float * value, float x, float y, float z)
+{
+  return value[0] == x && value[1] == y && value[2] == z;
+}
+
+//! firmware configuration: counter, time, acc, gyro, mag, status
+static const uint8_t measurement[] =
+{
+    0xFA, 0xFF, 0x36, 64,
+    0x10, 0x20, 2,  0x12, 0x34,					// packet counter 0x1234
+    0x10, 0x60, 4,  0x00, 0x01, 0xE2, 0x40,			// sample time fine 123456
+    0x40, 0x20, 12, 0x3F, 0x80, 0x00, 0x00, 0xC0, 0x20, 0x00, 0x00, 0x41, 0x1C, 0x00, 0x00, // acc 1, -2.5, 9.75
+    0x80, 0x20, 12, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x80, 0x00, 0x00, 0xBF, 0x00, 0x00, 0x00, // gyro 0, 0.25, -0.5
+    0xC0, 0x20, 12, 0x3F, 0x00, 0x00, 0x00, 0xBE, 0x80, 0x00, 0x00, 0x3F, 0x40, 0x00, 0x00, // mag 0.5, -0.25, 0.75
+    0xE0, 0x20, 4,  0x00, 0x00, 0x00, 0x03,			// status word 3
+    0xFC
+};
+
+//! skipped packets around a NED quaternion and delta v
+static const uint8_t mixed[] =
+{
+    0xFA, 0xFF, 0x36, 87,
+    0x10, 0x10, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// UTC time: unknown
+    0x20, 0x14, 16, 0x3F, 0x80, 0x00, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // quaternion NED 1, 0, 0, 0
+    0x40, 0x23, 24, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, // acc, double
+    0x40, 0x10, 12, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xBE, 0x00, 0x00, 0x00, // delta v 0.125, 0, -0.125
+    0x40, 0x20, 8,  0x3F, 0x80, 0x00, 0x00, 0x3F, 0x80, 0x00, 0x00, // acc, wrong size
+    0xF4
+};
+
+static void check_measurement( void)
+{
+  expect( Xbus::verifyChecksum( measurement), "measurement: literal checksum wrong");
+  MTData2_t output;
+  expect( decode_MTData2( measurement, sizeof( measurement), output), "measurement: rejected");
+  expect( output.present == (MTDATA2_PACKET_COUNTER | MTDATA2_SAMPLE_TIME_FINE | MTDATA2_ACCELERATION
+      | MTDATA2_RATE_OF_TURN | MTDATA2_MAGNETIC_FIELD | MTDATA2_STATUS_WORD), "measurement: present flags");
+  expect( output.packet_counter == 0x1234, "measurement: packet counter");
+  expect( output.sample_time_fine == 123456, "measurement: sample time fine");
+  expect( equal( output.acc, 1.0f, -2.5f, 9.75f), "measurement: acceleration");
+  expect( equal( output.gyro, 0.0f, 0.25f, -0.5f), "measurement: rate of turn");
+  expect( equal( output.mag, 0.5f, -0.25f, 0.75f), "measurement: magnetic field");
+  expect( output.status_word == 3, "measurement: status word");
+}
+
+static void check_mixed( void)
+{
+  expect( Xbus::verifyChecksum( mixed), "mixed: literal checksum wrong");
+  MTData2_t output;
+  expect( decode_MTData2( mixed, sizeof( mixed), output), "mixed: rejected");
+  expect( output.present == (MTDATA2_QUATERNION | MTDATA2_DELTA_V), "mixed: present flags");
+  expect( output.quaternion[0] == 1.0f && equal( output.quaternion + 1, 0.0f, 0.0f, 0.0f), "mixed: quaternion");
+  expect( equal( output.delta_v, 0.125f, 0.0f, -0.125f), "mixed: delta v");
+}
+
+//! 413 byte payload: two unknown packets of 200 bytes, a status word behind them
+static void check_extended_length( void)
+{
+  static uint8_t message[6 + 413 + 1];
+  Xbus::message( message, 0xFF, XMID_MtData2, 413);
+  uint8_t * packet = Xbus::getPointerToPayload( message);
+  for( unsigned i = 0; i < 2; ++i, packet += 203)
+    {
+      packet[0] = 0x0B; // unknown group
+      packet[1] = 0x00;
+      packet[2] = 200;
+      memset( packet + 3, 0xFA, 200); // preambles in the data
+    }
+  const uint8_t status[] = { 0xE0, 0x20, 4, 0x80, 0x00, 0x00, 0x01};
+  memcpy( packet, status, sizeof( status));
+  Xbus::insertChecksum( message);
+
+  MTData2_t output;
+  expect( decode_MTData2( message, sizeof( message), output), "extended length: rejected");
+  expect( output.present == MTDATA2_STATUS_WORD && output.status_word == 0x80000001, "extended length: status word");
+  expect( ! decode_MTData2( message, sizeof( message) - 2, output), "extended length: truncated message accepted");
+}
+
+static void check_rejected( void)
+{
+  uint8_t message[sizeof( measurement)];
+  MTData2_t output;
+
+  memcpy( message, measurement, sizeof( message));
+  message[2] = XMID_MtData2 - 2; // other MID
+  expect( ! decode_MTData2( message, sizeof( message), output) && output.present == 0, "other MID accepted");
+
+  expect( ! decode_MTData2( measurement, sizeof( measurement) - 2, output), "truncated message accepted");
+  expect( ! decode_MTData2( measurement, 3, output), "header only accepted");
+
+  memcpy( message, measurement, sizeof( message));
+  message[4 + 5 + 7 + 15 + 15 + 15 + 2] = 5; // status word packet reaching past the payload
+  expect( ! decode_MTData2( message, sizeof( message), output), "packet past the end accepted");
+}
+
+int main( void)
+{
+  check_measurement();
+  check_mixed();
+  check_extended_length();
+  check_rejected();
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
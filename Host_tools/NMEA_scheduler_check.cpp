@@ -0,0 +1,83 @@
+/** ***********************************************************************
+ * @file		NMEA_scheduler_check.cpp
+ * @brief		host check: NMEA sentence rates and repeated sentence types
+ *
+ * Feeds a set with one $GPGSV per satellite system and checks that every
+ * sentence is sent with its period, none is lost and the order is kept.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Core/Inc NMEA_scheduler_check.cpp ../Core/Src/NMEA_scheduler.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "NMEA_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+
+static const NMEA_schedule_t schedule[] =
+{
+    { "PLARV", 1 },
+    { "GPRMC", 4 },
+};
+
+static const char set[] =
+    "$PLARV,1*00\r\n"
+    "$GPRMC,2*00\r\n"
+    "$GPGSV,1,3*00\r\n"
+    "$GPGSV,2,3*00\r\n"
+    "$GPGSV,3,3*00\r\n"
+    "$POV,E,1*00\r\n";
+
+static unsigned count( const char * text, const char * pattern)
+{
+  unsigned n = 0;
+  for( const char * p = strstr( text, pattern); p; p = strstr( p + 1, pattern))
+    ++n;
+  return n;
+}
+
+int main( void)
+{
+  NMEA_scheduler scheduler( schedule, sizeof( schedule) / sizeof( NMEA_schedule_t), 2);
+  unsigned failures = 0;
+  char output[1024];
+
+  for( unsigned tick = 0; tick < 40; ++tick)
+    {
+      if( scheduler.tick())
+	scheduler.update( set, sizeof( set) - 1);
+      unsigned length = scheduler.compose( output, sizeof( output) - 1);
+      output[length] = 0;
+
+      unsigned expected_PLARV = 1;
+      unsigned expected_GPRMC = tick % 4 == 0;
+      unsigned expected_GPGSV = tick % 2 == 0 ? 3 : 0;
+      unsigned expected_POV   = tick % 2 == 0;
+      if(    count( output, "$PLARV") != expected_PLARV
+	  || count( output, "$GPRMC") != expected_GPRMC
+	  || count( output, "$GPGSV") != expected_GPGSV
+	  || count( output, "$POV")   != expected_POV)
+	{
+	  printf( "tick %u: unexpected set\n%s", tick, output);
+	  ++failures;
+	}
+
+      const char * first = strstr( output, "$GPGSV,1,3");
+      const char * second = strstr( output, "$GPGSV,2,3");
+      const char * third = strstr( output, "$GPGSV,3,3");
+      if( expected_GPGSV && ! (first && second && third && first < second && second < third))
+	{
+	  printf( "tick %u: GSV order lost\n", tick);
+	  ++failures;
+	}
+    }
+
+  if( scheduler.dropped != 0 || scheduler.duplicates != 2)
+    {
+      printf( "dropped %u, duplicate slots %u\n", (unsigned)scheduler.dropped, (unsigned)scheduler.duplicates);
+      ++failures;
+    }
+
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/** ***********************************************************************
+ * @file		UBX_parser_check.cpp
+ * @brief		host check: UBX framing on fragmented and corrupted streams
+ *
+ * A receiver stream of 20000 frames of random class, id and length
+ * (0 .. UBX_MAX_PAYLOAD) is mixed with NMEA sentences, random garbage
+ * (which may contain sync characters), oversized frames and frames with
+ * one corrupted byte, the length field included. The stream is fed in
+ * random fragments of 1 .. 600 bytes, as DMA reception delivers it.
+ * - every frame delivered must be an unmodified frame of the stream,
+ * - a corrupted frame must never be delivered,
+ * - an intact frame may only be lost if it starts within the maximum
+ *   frame size behind a disturbance, a corrupted length or garbage with
+ *   sync characters swallowing it,
+ * - the error counters must account for the disturbances.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom UBX_parser_check.cpp ../Drivers/Custom/UBX_parser.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "UBX_parser.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define FRAMES			20000
+#define MAX_FRAGMENT		600
+#define SWALLOW_RANGE		(UBX_MAX_PAYLOAD + UBX_FRAME_OVERHEAD)
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static uint32_t random_bits( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return (uint32_t)((random_state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+struct sent_frame
+{
+  size_t position;	//!< of the first sync character in the stream
+  size_t size;
+  bool intact;
+  bool delivered;
+};
+
+static std::vector<uint8_t> stream;
+static std::vector<sent_frame> sent;
+static std::vector<size_t> disturbances; //!< stream positions
+
+static void append_frame( unsigned length, bool corrupt)
+{
+  size_t start = stream.size();
+  uint8_t cls = random_bits() % 8 == 0 ? UBX_CLASS_NAV : random_bits();
+  uint8_t header[6] = { UBX_SYNC_1, UBX_SYNC_2, cls, (uint8_t)random_bits(), (uint8_t)length, (uint8_t)(length >> 8)};
+  stream.insert( stream.end(), header, header + 6);
+  for( unsigned i = 0; i < length; ++i)
+    stream.push_back( random_bits() % 16 == 0 ? UBX_SYNC_1 : random_bits()); // sync characters inside frames
+  uint8_t CK_A = 0, CK_B = 0;
+  for( size_t i = start + 2; i < stream.size(); ++i)
+    {
+      CK_A += stream[i];
+      CK_B += CK_A;
+    }
+  stream.push_back( CK_A);
+  stream.push_back( CK_B);
+  if( corrupt)
+    {
+      size_t position = start + 2 + random_bits() % (stream.size() - start - 2); // class .. CK_B
+      stream[position] ^= 1 + random_bits() % 255;
+      disturbances.push_back( start);
+    }
+  sent.push_back( { start, stream.size() - start, ! corrupt, false});
+}
+
+static void append_garbage( void)
+{
+  disturbances.push_back( stream.size());
+  unsigned size = 1 + random_bits() % 100;
+  for( unsigned i = 0; i < size; ++i)
+    {
+      unsigned r = random_bits() % 32;
+      stream.push_back( r == 0 ? UBX_SYNC_1 : r == 1 ? UBX_SYNC_2 : random_bits());
+    }
+}
+
+static void append_NMEA( void)
+{
+  const char * sentence = "$GNGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B\r\n";
+  stream.insert( stream.end(), sentence, sentence + strlen( sentence));
+}
+
+static void build_stream( unsigned * corrupted, unsigned * oversized)
+{
+  *corrupted = *oversized = 0;
+  for( unsigned n = 0; n < FRAMES; ++n)
+    {
+      unsigned r = random_bits() % 100;
+      if( r < 5)
+	append_garbage();
+      else if( r < 10)
+	append_NMEA();
+      else if( r == 10)
+	{
+	  // oversized: header only, the parser must resynchronize behind it
+	  disturbances.push_back( stream.size());
+	  uint16_t length = UBX_MAX_PAYLOAD + 1 + random_bits() % 1000;
+	  uint8_t header[6] = { UBX_SYNC_1, UBX_SYNC_2, UBX_CLASS_NAV, UBX_NAV_PVT, (uint8_t)length, (uint8_t)(length >> 8)};
+	  stream.insert( stream.end(), header, header + 6);
+	  ++*oversized;
+	}
+      else if( r == 11) // 0xb5 0xb5 'b' starts a frame
+	stream.push_back( UBX_SYNC_1);
+
+      bool corrupt = random_bits() % 20 == 0;
+      if( corrupt)
+	++*corrupted;
+      unsigned length = random_bits() % 4 == 0 ? 92 : random_bits() % (UBX_MAX_PAYLOAD + 1);
+      append_frame( length, corrupt);
+    }
+}
+
+//! @return index of the sent frame ending at this stream position with this content, -1 if none
+static int match( size_t end, const uint8_t * frame, size_t size)
+{
+  static size_t next = 0;
+  while( next < sent.size() && sent[next].position + sent[next].size < end)
+    ++next;
+  if( next == sent.size() || sent[next].position + sent[next].size != end || sent[next].size != size
+      || memcmp( &stream[sent[next].position], frame, size) != 0)
+    return -1;
+  return next;
+}
+
+int main( void)
+{
+  unsigned corrupted, oversized;
+  build_stream( &corrupted, &oversized);
+
+  UBX_parser parser;
+  unsigned failures = 0;
+  unsigned foreign = 0;
+  for( size_t position = 0; position < stream.size(); )
+    {
+      size_t fragment = 1 + random_bits() % MAX_FRAGMENT;
+      if( fragment > stream.size() - position)
+	fragment = stream.size() - position;
+      for( size_t end = position + fragment; position < end; ++position)
+	{
+	  if( ! parser.feed( stream[position]))
+	    continue;
+	  size_t size = parser.get_payload_length() + UBX_FRAME_OVERHEAD;
+	  int index = match( position + 1, parser.get_frame(), size);
+	  if( index < 0 || ! sent[index].intact)
+	    {
+	      if( foreign < 5)
+		printf( "frame delivered at %zu which has not been sent intact\n", position);
+	      ++foreign;
+	    }
+	  else
+	    sent[index].delivered = true;
+	}
+    }
+  failures += foreign;
+
+  unsigned intact = 0, delivered = 0, swallowed = 0, lost = 0;
+  size_t disturbance = 0;
+  for( const sent_frame & frame : sent)
+    {
+      if( ! frame.intact)
+	continue;
+      ++intact;
+      if( frame.delivered)
+	{
+	  ++delivered;
+	  continue;
+	}
+      while( disturbance + 1 < disturbances.size() && disturbances[disturbance + 1] < frame.position)
+	++disturbance;
+      if( disturbances[disturbance] < frame.position && frame.position - disturbances[disturbance] <= SWALLOW_RANGE)
+	++swallowed;
+      else
+	{
+	  if( lost < 5)
+	    printf( "intact frame at %zu lost without a disturbance before it\n", frame.position);
+	  ++lost;
+	}
+    }
+  failures += lost;
+
+  if( parser.frames != delivered)
+    {
+      printf( "frame counter %u, %u delivered\n", parser.frames, delivered);
+      ++failures;
+    }
+  if( parser.oversized_frames < oversized || parser.checksum_errors + parser.oversized_frames < corrupted)
+    {
+      printf( "error counters %u checksum %u oversized below the %u corrupted, %u oversized frames sent\n",
+	      parser.checksum_errors, parser.oversized_frames, corrupted, oversized);
+      ++failures;
+    }
+
+  printf( "%zu bytes, %u intact frames: %u delivered, %u swallowed by a disturbance\n",
+	  stream.size(), intact, delivered, swallowed);
+  printf( "%u corrupted, %u oversized sent, counted %u checksum errors, %u oversized\n",
+	  corrupted, oversized, parser.checksum_errors, parser.oversized_frames);
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+/** ***********************************************************************
+ * @file		ffconf.h
+ * @brief		FatFs configuration for host builds
+ *
+ * Same options as FATFS/Target/ffconf.h without the MCU headers,
+ * f_mkfs () enabled to format RAM disks.
+ **************************************************************************/
+
+#ifndef _FFCONF
+#define _FFCONF 68300	/* Revision ID */
+
+#define _FS_READONLY	0
+#define _FS_MINIMIZE	0
+#define _USE_STRFUNC	2
+#define _USE_FIND	0
+#define _USE_MKFS	1	// target: 0
+#define _USE_FASTSEEK	0
+#define	_USE_EXPAND	1
+#define _USE_CHMOD	0
+#define _USE_LABEL	0
+#define _USE_FORWARD	0
+
+#define _CODE_PAGE	850
+#define _USE_LFN	2
+#define _MAX_LFN	255
+#define _LFN_UNICODE	0
+#define _STRF_ENCODE	3
+#define _FS_RPATH	0
+
+#define _VOLUMES	1
+#define _STR_VOLUME_ID	0
+#define _VOLUME_STRS	"RAM","NAND","CF","SD1","SD2","USB1","USB2","USB3"
+#define _MULTI_PARTITION	0
+#define _MIN_SS		512
+#define _MAX_SS		2048
+#define	_USE_TRIM	0
+#define _FS_NOFSINFO	0
+
+#define _FS_TINY	0
+#define _FS_EXFAT	0
+#define _FS_NORTC	0
+#define _NORTC_MON	6
+#define _NORTC_MDAY	4
+#define _NORTC_YEAR	2015
+#define _FS_LOCK	4
+#define _FS_REENTRANT	0
+
+#endif /* _FFCONF */
@@ -0,0 +1,111 @@
+/** ***********************************************************************
+ * @file		fixed_point_format_check.cpp
+ * @brief		host check: format_fixed () against printf, and benchmark
+ *
+ * Random floats (random bit patterns and values in +/- 1000) are formatted
+ * with 0, 3 and 6 decimals and compared character by character with
+ * snprintf( "%.*f"). Values outside the valid range ("ovf") are counted
+ * but not compared. Afterwards both formatters are timed.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Core/Inc fixed_point_format_check.cpp ../Core/Src/fixed_point_format.cpp
+ * ./a.out [samples per test, default 1000000]
+ **************************************************************************/
+
+#include "fixed_point_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+static uint64_t random_state = 0x853c49e6748fea9bULL;
+
+static uint32_t random_bits( void) // xorshift64*
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return (uint32_t)((random_state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static float random_float( bool any_bit_pattern)
+{
+  if( any_bit_pattern)
+    {
+      union { uint32_t u; float f; } x;
+      do
+	x.u = random_bits();
+      while( ! isfinite( x.f));
+      return x.f;
+    }
+  return ((float)random_bits() / 4294967296.0f - 0.5f) * 2000.0f;
+}
+
+template <unsigned DECIMALS>
+static bool compare( unsigned samples)
+{
+  unsigned mismatches = 0, overflows = 0;
+  char own[64], reference[64];
+
+  for( unsigned i = 0; i < samples; ++i)
+    {
+      float value = random_float( i & 1);
+      *format_fixed<DECIMALS>( own, value) = 0;
+      if( strstr( own, "ovf"))
+	{
+	  ++overflows;
+	  continue;
+	}
+      snprintf( reference, sizeof( reference), "%.*f", DECIMALS, (double)value);
+      if( strcmp( own, reference) != 0 && ++mismatches <= 10)
+	printf( "%.9g: \"%s\" != \"%s\"\n", (double)value, own, reference);
+    }
+
+  printf( "%u decimals: %u values, %u mismatches, %u out of range\n",
+	  DECIMALS, samples, mismatches, overflows);
+  return mismatches == 0;
+}
+
+static double seconds( void)
+{
+  timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+static void benchmark( unsigned samples)
+{
+  float * values = new float[samples];
+  for( unsigned i = 0; i < samples; ++i)
+    values[i] = random_float( false);
+
+  char text[64];
+  unsigned checksum = 0; // keeps the optimizer from removing the loops
+
+  double start = seconds();
+  for( unsigned i = 0; i < samples; ++i)
+    checksum += format_fixed<3>( text, values[i]) - text;
+  double own = seconds() - start;
+
+  start = seconds();
+  for( unsigned i = 0; i < samples; ++i)
+    checksum += snprintf( text, sizeof( text), "%.3f", (double)values[i]);
+  double reference = seconds() - start;
+
+  printf( "3 decimals, +/- 1000: format_fixed %.1f ns, snprintf %.1f ns per value (%u)\n",
+	  1e9 * own / samples, 1e9 * reference / samples, checksum);
+  delete [] values;
+}
+
+int main( int argc, char * argv[])
+{
+  unsigned samples = argc > 1 ? (unsigned)atol( argv[1]) : 1000000;
+
+  bool ok = compare<0>( samples);
+  ok = compare<3>( samples) && ok;
+  ok = compare<6>( samples) && ok;
+  benchmark( samples);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/** ***********************************************************************
+ * @file		log_archive.cpp
+ * @brief		host tool: summary statistics of a whole flight log archive
+ *
+ * All logs of a directory (*.c50, *.h50, legacy *.f50 / *.f37) are
+ * memory-mapped by log_reader and processed by one worker thread per core,
+ * each taking the next file when it is done with its present one.
+ * One CSV line per flight on stdout, in file name order:
+ * records, duration, GNSS climb and ground speed maxima, and the rms
+ * difference between the barometric and the GNSS vertical speed on a
+ * one second grid (vario residual of the raw sensors).
+ * Legacy files carry no channel table, only records and duration are given.
+ * Statistics of the algorithm outputs (vario, wind, attitude) need
+ * organizer_t from the lib submodule and are not computed here.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -pthread -I../Drivers/Custom log_archive.cpp log_reader.cpp ../Drivers/Custom/log_compression.cpp -o log_archive
+ * ./log_archive <directory> [threads]
+ **************************************************************************/
+
+#include "log_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <dirent.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define LEGACY_SAMPLE_RATE	100	// *.f50 / *.f37 do not tell
+
+struct flight_summary
+{
+  bool readable;
+  bool channels;		//!< statistics below valid
+  uint64_t records;
+  double duration;		//!< s
+  double max_climb;		//!< GNSS, m/s
+  double max_sink;		//!< GNSS, m/s
+  double max_ground_speed;	//!< m/s
+  double vario_residual;	//!< rms, m/s
+};
+
+static bool is_log_file( const char * name)
+{
+  const char * dot = strrchr( name, '.');
+  return dot != 0 && (strcmp( dot, ".c50") == 0 || strcmp( dot, ".h50") == 0
+      || (dot[1] == 'f' && atoi( dot + 2) > 0));
+}
+
+//! standard atmosphere altitude in m
+static double pressure_altitude( double pressure)
+{
+  return 44330.0 * (1.0 - pow( pressure / 101325.0, 0.190263));
+}
+
+static flight_summary summarize( const std::string & filename)
+{
+  flight_summary summary;
+  memset( &summary, 0, sizeof( summary));
+  log_reader reader;
+  if( ! reader.open( filename.c_str()))
+    return summary;
+  summary.readable = true;
+
+  const log_header_t * header = reader.header();
+  unsigned rate = header ? header->sample_rate : LEGACY_SAMPLE_RATE;
+  const log_channel_descriptor_t * pressure = reader.channel( "static_pressure");
+  const log_channel_descriptor_t * velocity = reader.channel( "velocity");
+  summary.channels = pressure != 0 && velocity != 0 && rate > 0;
+
+  // one second sums of altitude and GNSS climb, for the residual
+  double second_altitude = 0.0, second_climb = 0.0, previous_altitude = 0.0, previous_climb = 0.0;
+  double residual_sum = 0.0;
+  unsigned in_second = 0, seconds = 0;
+
+  const uint32_t * record;
+  while( (record = reader.next()) != 0)
+    {
+      if( ! summary.channels)
+	continue;
+      double climb = -log_reader::value( record, velocity, 2); // NED
+      double north = log_reader::value( record, velocity, 0);
+      double east = log_reader::value( record, velocity, 1);
+      summary.max_climb = std::max( summary.max_climb, climb);
+      summary.max_sink = std::max( summary.max_sink, -climb);
+      summary.max_ground_speed = std::max( summary.max_ground_speed, sqrt( north * north + east * east));
+
+      second_altitude += pressure_altitude( log_reader::value( record, pressure));
+      second_climb += climb;
+      if( ++in_second < rate)
+	continue;
+      // the difference of two mean altitudes is centred between the two seconds
+      double altitude = second_altitude / rate;
+      if( seconds > 0)
+	{
+	  double difference = (altitude - previous_altitude) - (second_climb + previous_climb) / (2 * rate);
+	  residual_sum += difference * difference;
+	}
+      previous_altitude = altitude;
+      previous_climb = second_climb;
+      ++seconds;
+      second_altitude = second_climb = 0.0;
+      in_second = 0;
+    }
+
+  summary.records = reader.record_index();
+  summary.duration = rate ? (double)summary.records / rate : 0.0;
+  if( seconds > 1)
+    summary.vario_residual = sqrt( residual_sum / (seconds - 1));
+  return summary;
+}
+
+int main( int argc, char ** argv)
+{
+  if( argc < 2 || argc > 3)
+    {
+      fprintf( stderr, "usage: %s <directory> [threads]\n", argv[0]);
+      return 2;
+    }
+
+  DIR * directory = opendir( argv[1]);
+  if( directory == 0)
+    {
+      fprintf( stderr, "%s: can not be read\n", argv[1]);
+      return 1;
+    }
+  std::vector<std::string> files;
+  struct dirent * entry;
+  while( (entry = readdir( directory)) != 0)
+    if( is_log_file( entry->d_name))
+      files.push_back( std::string( argv[1]) + "/" + entry->d_name);
+  closedir( directory);
+  std::sort( files.begin(), files.end());
+
+  unsigned threads = argc == 3 ? atoi( argv[2]) : std::thread::hardware_concurrency();
+  if( threads == 0)
+    threads = 1;
+
+  std::vector<flight_summary> summaries( files.size());
+  std::atomic<size_t> next_file( 0);
+  struct timespec start, stop;
+  clock_gettime( CLOCK_MONOTONIC, &start);
+
+  std::vector<std::thread> workers;
+  for( unsigned i = 0; i < threads; ++i)
+    workers.emplace_back( [&]()
+      {
+	size_t n;
+	while( (n = next_file++) < files.size())
+	  summaries[n] = summarize( files[n]);
+      });
+  for( std::thread & worker : workers)
+    worker.join();
+
+  clock_gettime( CLOCK_MONOTONIC, &stop);
+  double elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+  uint64_t total_records = 0;
+  unsigned failed = 0;
+  printf( "file,records,duration_s,max_climb,max_sink,max_ground_speed,vario_residual_rms\n");
+  for( size_t n = 0; n < files.size(); ++n)
+    {
+      const flight_summary & s = summaries[n];
+      if( ! s.readable)
+	{
+	  fprintf( stderr, "%s: can not be read\n", files[n].c_str());
+	  ++failed;
+	  continue;
+	}
+      total_records += s.records;
+      if( s.channels)
+	printf( "%s,%llu,%.1f,%.2f,%.2f,%.2f,%.3f\n", files[n].c_str(), (unsigned long long)s.records, s.duration,
+		s.max_climb, s.max_sink, s.max_ground_speed, s.vario_residual);
+      else
+	printf( "%s,%llu,%.1f,,,,\n", files[n].c_str(), (unsigned long long)s.records, s.duration);
+    }
+  fprintf( stderr, "%zu files, %llu records in %.2f s with %u threads: %.1f M records/s\n", files.size(),
+	   (unsigned long long)total_records, elapsed, threads, total_records / elapsed * 1e-6);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+/** ***********************************************************************
+ * @file		log_compression_check.cpp
+ * @brief		host check: compressed log round trip, NaN and saturation
+ *
+ * A synthetic flight (random walks, NaN phases as without GNSS fix,
+ * infinity and out of range values, lossless words) is encoded block by
+ * block and decoded again. Quantized words must be within half a quantum,
+ * NaN must stay NaN, lossless words must be bit-exact.
+ * Every block is decoded on its own.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom log_compression_check.cpp ../Drivers/Custom/log_compression.cpp
+ * ./a.out [records, default 360000 = 1 hour]
+ **************************************************************************/
+
+#include "log_format.h"
+#include "log_compression.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+// words 0 .. 39 quantized float, 40 .. 49 lossless
+static const log_channel_descriptor_t channels[] =
+{
+    { "acc",		0,  LOG_FLOAT32, 3, 1e-3f },
+    { "gyro",		12, LOG_FLOAT32, 3, 1e-5f },
+    { "mag",		24, LOG_FLOAT32, 3, 1e-4f },
+    { "pressure",	36, LOG_FLOAT32, 1, 1e-2f },
+    { "velocity",	40, LOG_FLOAT32, 3, 1e-3f },	// NaN without fix
+    { "other",		52, LOG_FLOAT32, 27, 1e-3f },
+    { "latitude",	160, LOG_FLOAT64, 1, 0.0f },
+    { "longitude",	168, LOG_FLOAT64, 1, 0.0f },
+    { "raw",		176, LOG_UINT32, 6, 0.0f },
+};
+#define QUANTIZED_WORDS 40
+
+static uint64_t random_state = 0x2545f4914f6cdd1dULL;
+
+static double uniform( void) // -1 .. 1
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return (double)((random_state * 0x2545f4914f6cdd1dULL) >> 11) / 4503599627370496.0 - 1.0;
+}
+
+static float quantum_of( unsigned word)
+{
+  for( const log_channel_descriptor_t & c : channels)
+    if( c.type == LOG_FLOAT32 && word >= c.offset / 4u && word < c.offset / 4u + c.count)
+      return c.quantum;
+  return 0.0f;
+}
+
+static void make_record( unsigned n, float * state, uint32_t * record)
+{
+  for( unsigned i = 0; i < QUANTIZED_WORDS; ++i)
+    {
+      state[i] += (float)uniform() * 10.0f * quantum_of( i);
+      memcpy( record + i, state + i, sizeof( float));
+    }
+  if( (n / 1000) % 7 == 3) // no GNSS fix for a while
+    {
+      const float nan = NAN;
+      for( unsigned i = 10; i < 13; ++i)
+	memcpy( record + i, &nan, sizeof( float));
+    }
+  float special = n % 5000 == 17 ? INFINITY : -1e30f;
+  if( n % 5000 == 17 || n % 5000 == 18)
+    memcpy( record + 20, &special, sizeof( float));
+  for( unsigned i = QUANTIZED_WORDS; i < LOG_RECORD_WORDS; ++i)
+    record[i] = (i & 1) ? n * 10 : (uint32_t)(random_state >> 40);
+}
+
+static bool matches( unsigned word, uint32_t original_bits, uint32_t decoded_bits)
+{
+  float quantum = quantum_of( word);
+  if( quantum == 0.0f)
+    return original_bits == decoded_bits;
+
+  float original, decoded;
+  memcpy( &original, &original_bits, sizeof( float));
+  memcpy( &decoded, &decoded_bits, sizeof( float));
+  if( isnan( original))
+    return isnan( decoded);
+  if( fabsf( original / quantum) >= (float)LOG_QUANTIZED_LIMIT)
+    return fabsf( decoded / quantum - copysignf( (float)LOG_QUANTIZED_LIMIT, original)) < 1.0f;
+  return fabsf( decoded - original) <= 0.5f * quantum + 1e-6f * fabsf( original);
+}
+
+int main( int argc, char ** argv)
+{
+  unsigned total = argc > 1 ? atoi( argv[1]) : 360000;
+  log_quantization quantization( channels, sizeof( channels) / sizeof( channels[0]));
+
+  std::vector<uint32_t> records( (size_t)total * LOG_RECORD_WORDS);
+  float state[QUANTIZED_WORDS];
+  for( unsigned i = 0; i < QUANTIZED_WORDS; ++i)
+    state[i] = (float)uniform() * 100.0f;
+  for( unsigned n = 0; n < total; ++n)
+    make_record( n, state, &records[(size_t)n * LOG_RECORD_WORDS]);
+
+  // encode
+  std::vector<uint8_t> file;
+  uint8_t block[LOG_COMPRESSED_BLOCK_SIZE];
+  log_block_encoder encoder( block, quantization);
+  for( unsigned n = 0; n < total; )
+    if( encoder.append( &records[(size_t)n * LOG_RECORD_WORDS]))
+      ++n;
+    else
+      {
+	encoder.finish();
+	file.insert( file.end(), block, block + sizeof( block));
+	encoder.start();
+      }
+  if( ! encoder.is_empty())
+    {
+      encoder.finish();
+      file.insert( file.end(), block, block + sizeof( block));
+    }
+
+  // decode block by block
+  unsigned decoded = 0, mismatches = 0, nans = 0;
+  uint32_t record[LOG_RECORD_WORDS];
+  for( size_t offset = 0; offset < file.size(); offset += LOG_COMPRESSED_BLOCK_SIZE)
+    {
+      log_block_decoder decoder( quantization);
+      if( ! decoder.start( &file[offset]))
+	{
+	  printf( "block at %zu rejected\n", offset);
+	  ++mismatches;
+	  continue;
+	}
+      while( decoder.decode( record))
+	{
+	  if( decoded >= total)
+	    {
+	      ++mismatches;
+	      break;
+	    }
+	  const uint32_t * original = &records[(size_t)decoded * LOG_RECORD_WORDS];
+	  for( unsigned i = 0; i < LOG_RECORD_WORDS; ++i)
+	    if( ! matches( i, original[i], record[i]))
+	      {
+		if( mismatches < 10)
+		  printf( "record %u word %u: %08x -> %08x\n", decoded, i, original[i], record[i]);
+		++mismatches;
+	      }
+	  float velocity;
+	  memcpy( &velocity, record + 10, sizeof( float));
+	  nans += isnan( velocity);
+	  ++decoded;
+	}
+    }
+
+  if( decoded != total)
+    {
+      printf( "%u of %u records decoded\n", decoded, total);
+      ++mismatches;
+    }
+  if( nans == 0)
+    {
+      printf( "NaN lost\n");
+      ++mismatches;
+    }
+
+  printf( "%u records, %zu bytes compressed, ratio %.2f, %u NaN velocities\n",
+	  total, file.size(), (double)total * LOG_RECORD_WORDS * 4 / file.size(), nans);
+  printf( "%s: %u mismatches\n", mismatches ? "FAILED" : "passed", mismatches);
+  return mismatches ? 1 : 0;
+}
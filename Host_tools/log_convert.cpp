@@ -0,0 +1,60 @@
+/** ***********************************************************************
+ * @file		log_convert.cpp
+ * @brief		host tool: flight log to legacy headerless .f50 records
+ *
+ * Converts a compressed .c50 log into the legacy raw layout that existing
+ * post-processing reads: one record after the other, no header.
+ * The quantization is taken from the channel table in the file header,
+ * logs of older firmware versions are decoded correctly.
+ * Raw logs with header are stripped, legacy logs are copied.
+ * Preallocated logs end at the size recorded in their .IDX file.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom log_convert.cpp log_reader.cpp ../Drivers/Custom/log_compression.cpp -o log_convert
+ * ./log_convert 20260101120000.c50 20260101120000.f50
+ **************************************************************************/
+
+#include "log_reader.h"
+#include <stdio.h>
+
+int main( int argc, char ** argv)
+{
+  if( argc != 3)
+    {
+      fprintf( stderr, "usage: %s <input log> <output .f50>\n", argv[0]);
+      return 2;
+    }
+
+  log_reader reader;
+  if( ! reader.open( argv[1]))
+    {
+      fprintf( stderr, "%s: can not be read\n", argv[1]);
+      return 1;
+    }
+
+  const log_header_t * header = reader.header();
+  if( header)
+    fprintf( stderr, "%s: %s, firmware %.*s, %u Hz\n", argv[1],
+	     header->format == LOG_FORMAT_COMPRESSED ? "compressed" : "raw",
+	     LOG_FIRMWARE_LENGTH, header->firmware, header->sample_rate);
+
+  FILE * output = fopen( argv[2], "wb");
+  if( output == 0)
+    {
+      perror( argv[2]);
+      return 1;
+    }
+
+  const uint32_t * record;
+  while( (record = reader.next()) != 0) // invalid compressed blocks are skipped
+    fwrite( record, sizeof( uint32_t), reader.record_words(), output);
+
+  if( fclose( output) != 0)
+    {
+      perror( argv[2]);
+      return 1;
+    }
+
+  fprintf( stderr, "%llu records written\n", (unsigned long long)reader.record_index());
+  return 0;
+}
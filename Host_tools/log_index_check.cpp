@@ -0,0 +1,252 @@
+/** ***********************************************************************
+ * @file		log_index_check.cpp
+ * @brief		host check: time index (.IDX) and log_reader::seek()
+ *
+ * A synthetic 6 hour flight is written as .h50 and .c50 together with
+ * their time indices, built like the logger does: one entry every
+ * LOG_INDEX_INTERVAL seconds, raw files pointing to the first record
+ * starting within a 2048 byte block, compressed files to a block.
+ * Random times of day are looked up: the reader must continue at the last
+ * index point not later than the target, with the correct record number,
+ * and reach the target record reading forward.
+ * Behind the data old blocks are appended as on a preallocated log, the
+ * reader must stop at the size recorded in the index header.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom log_index_check.cpp log_reader.cpp ../Drivers/Custom/log_compression.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "log_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#define SAMPLE_RATE	100	// as data_logger.h
+#define INDEX_INTERVAL	5	// seconds, as data_logger.h
+#define BLOCK_SIZE	2048
+#define RECORD_SIZE	(LOG_RECORD_WORDS * sizeof( uint32_t))
+#define RECORDS		(6 * 3600 * SAMPLE_RATE)
+#define START_TIME_MS	(9 * 3600 * 1000)
+#define SEEKS		10000
+
+static const log_channel_descriptor_t channels[] =
+{
+    { "counter",	0,   LOG_FLOAT32, 1, 1.0f },
+    { "day_time_ms",	176, LOG_UINT32,  1, 0.0f },
+};
+
+static uint32_t day_time_ms( unsigned n)
+{
+  return START_TIME_MS + n * (1000 / SAMPLE_RATE);
+}
+
+static void make_record( unsigned n, uint32_t * record)
+{
+  memset( record, 0, RECORD_SIZE);
+  float counter = (float)(n % 100000);
+  memcpy( record, &counter, sizeof( counter));
+  record[176 / sizeof( uint32_t)] = day_time_ms( n);
+}
+
+static void write_header( FILE * file, log_record_format_t format)
+{
+  static uint8_t block[LOG_HEADER_SIZE];
+  memset( block, 0, sizeof( block));
+  log_header_t * header = (log_header_t *)block;
+  header->magic = LOG_HEADER_MAGIC;
+  header->version = LOG_HEADER_VERSION;
+  header->header_size = LOG_HEADER_SIZE;
+  header->record_size = RECORD_SIZE;
+  header->sample_rate = SAMPLE_RATE;
+  header->format = format;
+  header->channel_count = sizeof( channels) / sizeof( channels[0]);
+  memcpy( (void *)get_log_channels( header), channels, sizeof( channels));
+  fwrite( block, 1, sizeof( block), file);
+}
+
+static std::vector<log_index_entry_t> time_index; //!< of the file written last
+
+static void write_index( const char * filename, const std::vector<log_index_entry_t> & entries, uint32_t data_size)
+{
+  FILE * file = fopen( filename, "wb");
+  log_index_header_t header = { LOG_INDEX_MAGIC, LOG_INDEX_VERSION, sizeof( log_index_entry_t), data_size};
+  fwrite( &header, sizeof( header), 1, file);
+  fwrite( entries.data(), sizeof( log_index_entry_t), entries.size(), file);
+  fclose( file);
+}
+
+//! a log not cut by the logger yet: old data of an earlier flight behind the synchronized size
+static uint32_t append_stale_data( FILE * file)
+{
+  uint32_t data_size = ftell( file);
+  static uint8_t stale[64 * BLOCK_SIZE];
+  fseek( file, LOG_HEADER_SIZE, SEEK_SET);
+  size_t size = fread( stale, 1, sizeof( stale), file);
+  fseek( file, 0, SEEK_END);
+  fwrite( stale, 1, size, file);
+  return data_size;
+}
+
+static void write_raw( const char * filename)
+{
+  FILE * file = fopen( filename, "w+b");
+  write_header( file, LOG_FORMAT_RAW);
+  time_index.clear();
+  uint32_t record[LOG_RECORD_WORDS];
+  uint32_t next_index_record = 0;
+  for( unsigned n = 0; n < RECORDS; ++n)
+    {
+      make_record( n, record);
+      fwrite( record, RECORD_SIZE, 1, file);
+    }
+  // per written block: first record starting within it
+  for( uint64_t block = 0; block * BLOCK_SIZE < (uint64_t)RECORDS * RECORD_SIZE; ++block)
+    {
+      uint32_t n = (block * BLOCK_SIZE + RECORD_SIZE - 1) / RECORD_SIZE;
+      if( n < next_index_record || n >= RECORDS)
+	continue;
+      time_index.push_back( { day_time_ms( n), n, (uint32_t)(LOG_HEADER_SIZE + n * RECORD_SIZE)});
+      next_index_record = n + INDEX_INTERVAL * SAMPLE_RATE;
+    }
+  uint32_t data_size = append_stale_data( file);
+  fclose( file);
+  char name[256];
+  snprintf( name, sizeof( name), "%s.IDX", filename);
+  write_index( name, time_index, data_size);
+}
+
+static void write_compressed( const char * filename)
+{
+  FILE * file = fopen( filename, "w+b");
+  write_header( file, LOG_FORMAT_COMPRESSED);
+  time_index.clear();
+  log_quantization quantization( channels, sizeof( channels) / sizeof( channels[0]));
+  uint8_t block[LOG_COMPRESSED_BLOCK_SIZE];
+  log_block_encoder encoder( block, quantization);
+  uint32_t record[LOG_RECORD_WORDS];
+  uint32_t next_index_record = 0;
+  for( unsigned n = 0; n < RECORDS; )
+    {
+      make_record( n, record);
+      bool first_of_block = encoder.is_empty();
+      if( encoder.append( record))
+	{
+	  if( first_of_block && n >= next_index_record)
+	    {
+	      time_index.push_back( { day_time_ms( n), n, (uint32_t)ftell( file)});
+	      next_index_record = n + INDEX_INTERVAL * SAMPLE_RATE;
+	    }
+	  ++n;
+	  continue;
+	}
+      encoder.finish();
+      fwrite( block, 1, sizeof( block), file);
+      encoder.start();
+    }
+  encoder.finish();
+  fwrite( block, 1, sizeof( block), file);
+  uint32_t data_size = append_stale_data( file);
+  fclose( file);
+  char name[256];
+  snprintf( name, sizeof( name), "%s.IDX", filename);
+  write_index( name, time_index, data_size);
+}
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static uint32_t random_bits( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return (uint32_t)((random_state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static unsigned check( const char * filename)
+{
+  log_reader reader;
+  if( ! reader.open( filename))
+    {
+      printf( "%s: open failed\n", filename);
+      return 1;
+    }
+  const log_channel_descriptor_t * time_channel = reader.channel( "day_time_ms");
+
+  unsigned failures = 0;
+  if( reader.seek( START_TIME_MS - 1))
+    {
+      printf( "%s: seek before the first record succeeded\n", filename);
+      ++failures;
+    }
+
+  uint64_t records_read = 0;
+  clock_t start = clock();
+  for( unsigned i = 0; i < SEEKS; ++i)
+    {
+      uint32_t target = START_TIME_MS + random_bits() % (RECORDS * (1000 / SAMPLE_RATE));
+      if( ! reader.seek( target))
+	{
+	  printf( "%s: seek %u failed\n", filename, target);
+	  ++failures;
+	  continue;
+	}
+      // reference: last index point not later than the target
+      auto behind = std::upper_bound( time_index.begin(), time_index.end(), target,
+				      []( uint32_t t, const log_index_entry_t & entry) { return t < entry.day_time_ms; });
+      uint32_t expected = behind == time_index.begin() ? 0 : (behind - 1)->record;
+
+      const uint32_t * record = reader.next();
+      if( record == 0)
+	{
+	  ++failures;
+	  continue;
+	}
+      uint32_t time = (uint32_t)log_reader::value( record, time_channel);
+      if( reader.record_index() != expected + 1 || time != day_time_ms( expected))
+	{
+	  if( failures < 5)
+	    printf( "%s: target %u found %u record %llu\n", filename, target, time, (unsigned long long)reader.record_index() - 1);
+	  ++failures;
+	}
+      // read forward to the exact target, as an analysis would do
+      while( time < target && (record = reader.next()) != 0)
+	{
+	  time = (uint32_t)log_reader::value( record, time_channel);
+	  ++records_read;
+	}
+      uint32_t period_ms = 1000 / SAMPLE_RATE;
+      if( time != target + (period_ms - target % period_ms) % period_ms)
+	{
+	  if( failures < 5)
+	    printf( "%s: target %u not reached\n", filename, target);
+	  ++failures;
+	}
+    }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf( "%s: %u seeks to the exact record in %.3f s, %.0f records read per seek instead of %u\n",
+	  filename, SEEKS, seconds, (double)records_read / SEEKS, RECORDS / 2);
+
+  // the stale data behind the synchronized size must not show up
+  reader.rewind();
+  while( reader.next() != 0)
+    ;
+  if( reader.record_index() != RECORDS)
+    {
+      printf( "%s: %llu records instead of %u\n", filename, (unsigned long long)reader.record_index(), RECORDS);
+      ++failures;
+    }
+  return failures;
+}
+
+int main( void)
+{
+  write_raw( "/tmp/log_index_check.h50");
+  unsigned failures = check( "/tmp/log_index_check.h50");
+  write_compressed( "/tmp/log_index_check.c50");
+  failures += check( "/tmp/log_index_check.c50");
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/** ***********************************************************************
+ * @file		log_reader.cpp
+ * @brief		host library: streaming flight log reader
+ **************************************************************************/
+
+#include "log_reader.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+log_reader::log_reader( void)
+  : map( 0), mapped_size( 0), size( 0), data( 0), position( 0), end( 0), file_header( 0),
+    words( 0), compressed( false), record_number( 0), decoder( quantization)
+{}
+
+//! legacy file: record length from the extension, "*.f37" = 37 floats
+static unsigned words_from_name( const char * filename)
+{
+  const char * dot = strrchr( filename, '.');
+  if( dot == 0 || dot[1] != 'f')
+    return LOG_RECORD_WORDS;
+  unsigned words = atoi( dot + 2);
+  return words > 0 ? words : LOG_RECORD_WORDS;
+}
+
+//! @return valid size of a preallocated log from its index file, else file_size
+static size_t synchronized_size( const char * filename, size_t file_size)
+{
+  char index_filename[300];
+  snprintf( index_filename, sizeof( index_filename), "%s.IDX", filename);
+  FILE * file = fopen( index_filename, "rb");
+  if( file == 0)
+    return file_size;
+  log_index_header_t header;
+  bool valid = fread( &header, sizeof( header), 1, file) == 1
+      && header.magic == LOG_INDEX_MAGIC && header.version == LOG_INDEX_VERSION;
+  fclose( file);
+  return valid && header.data_size < file_size ? header.data_size : file_size;
+}
+
+bool log_reader::open( const char * name)
+{
+  close();
+  snprintf( filename, sizeof( filename), "%s", name);
+
+  int fd = ::open( filename, O_RDONLY);
+  if( fd < 0)
+    return false;
+  struct stat status;
+  if( fstat( fd, &status) != 0 || status.st_size == 0)
+    {
+      ::close( fd);
+      return false;
+    }
+  mapped_size = status.st_size;
+  void * mapping = mmap( 0, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close( fd);
+  if( mapping == MAP_FAILED)
+    {
+      map = 0;
+      mapped_size = 0;
+      return false;
+    }
+  map = (const uint8_t *)mapping;
+  madvise( mapping, mapped_size, MADV_SEQUENTIAL);
+  size = synchronized_size( filename, mapped_size); // card taken out before the logger could cut the file
+  end = map + size;
+
+  file_header = size >= LOG_HEADER_SIZE ? get_log_header( map) : 0;
+  if( file_header && file_header->header_size > size)
+    file_header = 0;
+
+  if( file_header)
+    {
+      words = file_header->record_size / sizeof( uint32_t);
+      compressed = file_header->format == LOG_FORMAT_COMPRESSED;
+      data = map + file_header->header_size;
+      if( compressed)
+	{
+	  if( words != LOG_RECORD_WORDS)
+	    {
+	      close(); // the codec handles one record size only
+	      return false;
+	    }
+	  quantization.setup( get_log_channels( file_header), file_header->channel_count);
+	}
+    }
+  else
+    {
+      words = words_from_name( filename);
+      compressed = false;
+      data = map;
+    }
+
+  rewind();
+  return true;
+}
+
+void log_reader::close( void)
+{
+  if( map)
+    munmap( (void *)map, mapped_size);
+  map = data = position = end = 0;
+  mapped_size = size = 0;
+  file_header = 0;
+  words = 0;
+  compressed = false;
+  record_number = 0;
+}
+
+void log_reader::rewind( void)
+{
+  position = data;
+  record_number = 0;
+  decoder = log_block_decoder( quantization);
+}
+
+bool log_reader::seek( uint32_t day_time_ms, const char * index_filename)
+{
+  if( map == 0)
+    return false;
+
+  char default_name[sizeof( filename) + 4];
+  if( index_filename == 0)
+    {
+      snprintf( default_name, sizeof( default_name), "%s.IDX", filename);
+      index_filename = default_name;
+    }
+
+  int fd = ::open( index_filename, O_RDONLY);
+  if( fd < 0)
+    return false;
+  struct stat status;
+  void * mapping = MAP_FAILED;
+  if( fstat( fd, &status) == 0 && (size_t)status.st_size >= sizeof( log_index_header_t))
+    mapping = mmap( 0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close( fd);
+  if( mapping == MAP_FAILED)
+    return false;
+
+  const log_index_header_t * header = (const log_index_header_t *)mapping;
+  const log_index_entry_t * entries = (const log_index_entry_t *)(header + 1);
+  size_t count = 0;
+  if( header->magic == LOG_INDEX_MAGIC && header->version == LOG_INDEX_VERSION
+      && header->entry_size == sizeof( log_index_entry_t))
+    count = (status.st_size - sizeof( log_index_header_t)) / sizeof( log_index_entry_t);
+
+  // last entry not later than day_time_ms
+  size_t low = 0, high = count;
+  while( low < high)
+    {
+      size_t mid = (low + high) / 2;
+      if( entries[mid].day_time_ms <= day_time_ms)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+
+  bool found = low > 0 && entries[low - 1].offset >= (size_t)(data - map) && entries[low - 1].offset < size;
+  if( found)
+    {
+      position = map + entries[low - 1].offset;
+      record_number = entries[low - 1].record;
+      decoder = log_block_decoder( quantization); // compressed: block starts with a key frame
+    }
+  munmap( mapping, status.st_size);
+  return found;
+}
+
+const uint32_t * log_reader::next_compressed( void)
+{
+  while( ! decoder.decode( record))
+    {
+      if( position + LOG_COMPRESSED_BLOCK_SIZE > end)
+	return 0;
+      const uint8_t * block = position;
+      position += LOG_COMPRESSED_BLOCK_SIZE;
+      (void)decoder.start( block); // an invalid block is skipped
+    }
+  ++record_number;
+  return record;
+}
+
+double log_reader::value( const uint32_t * record, const log_channel_descriptor_t * channel, unsigned element)
+{
+  const uint8_t * field = (const uint8_t *)record + channel->offset;
+  switch( channel->type)
+    {
+    case LOG_FLOAT32:
+      {
+	float value;
+	memcpy( &value, field + element * sizeof( float), sizeof( value));
+	return value;
+      }
+    case LOG_FLOAT64:
+      {
+	double value;
+	memcpy( &value, field + element * sizeof( double), sizeof( value));
+	return value;
+      }
+    case LOG_INT8:
+      return ((const int8_t *)field)[element];
+    case LOG_UINT8:
+      return field[element];
+    case LOG_INT16:
+      {
+	int16_t value;
+	memcpy( &value, field + element * sizeof( value), sizeof( value));
+	return value;
+      }
+    case LOG_UINT16:
+      {
+	uint16_t value;
+	memcpy( &value, field + element * sizeof( value), sizeof( value));
+	return value;
+      }
+    case LOG_INT32:
+      {
+	int32_t value;
+	memcpy( &value, field + element * sizeof( value), sizeof( value));
+	return value;
+      }
+    case LOG_UINT32:
+      {
+	uint32_t value;
+	memcpy( &value, field + element * sizeof( value), sizeof( value));
+	return value;
+      }
+    }
+  return 0.0;
+}
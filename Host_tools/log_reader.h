@@ -0,0 +1,113 @@
+/** ***********************************************************************
+ * @file		log_reader.h
+ * @brief		host library: streaming flight log reader
+ *
+ * Maps a log file into memory and hands out one record after the other.
+ * Raw records are not copied, compressed blocks are decoded on the fly.
+ * Channels are found by name in the file header, readers do not depend
+ * on the record layout of a particular firmware version.
+ * Formats: *.h50 raw with header, *.c50 compressed with header,
+ * legacy *.f50 / *.f37 raw without header, record length from the name.
+ * seek() jumps to a time of day using the <logfile>.IDX time index.
+ * Preallocated logs not yet cut by the logger end at the size in the index.
+ * Not part of the firmware, link with ../Drivers/Custom/log_compression.cpp.
+ **************************************************************************/
+
+#ifndef HOST_TOOLS_LOG_READER_H_
+#define HOST_TOOLS_LOG_READER_H_
+
+#include "log_format.h"
+#include "log_compression.h"
+#include <stddef.h>
+
+class log_reader
+{
+public:
+  log_reader( void);
+  ~log_reader( void)
+  {
+    close();
+  }
+
+  //! @return false if the file can not be mapped or has an unknown layout
+  bool open( const char * filename);
+  void close( void);
+
+  //! @return header or 0 for legacy files
+  const log_header_t * header( void) const
+  {
+    return file_header;
+  }
+
+  //! 32-bit words per record
+  unsigned record_words( void) const
+  {
+    return words;
+  }
+
+  //! @return next record, valid until the next call, or 0 at the end of the file
+  const uint32_t * next( void)
+  {
+    if( ! compressed && position + words * sizeof( uint32_t) <= end)
+      {
+	const uint32_t * record = (const uint32_t *)position;
+	position += words * sizeof( uint32_t);
+	++record_number;
+	return record;
+      }
+    return compressed ? next_compressed() : 0;
+  }
+
+  //! continue with the first record
+  void rewind( void);
+
+  /*! continue at the last index point at or before day_time_ms (GNSS time of day)
+   *  binary search over the mapped index file, default <logfile>.IDX
+   *  @return false if no index is available, position unchanged then */
+  bool seek( uint32_t day_time_ms, const char * index_filename = 0);
+
+  //! number of the record delivered next
+  uint64_t record_index( void) const
+  {
+    return record_number;
+  }
+
+  //! @return channel descriptor or 0 if unknown (legacy file or not recorded)
+  const log_channel_descriptor_t * channel( const char * name) const
+  {
+    return file_header ? find_log_channel( file_header, name) : 0;
+  }
+
+  //! value of a channel element of any type as double
+  static double value( const uint32_t * record, const log_channel_descriptor_t * channel, unsigned element = 0);
+
+  //! valid part of the file in memory, e.g. for an own parser
+  const uint8_t * file_data( void) const
+  {
+    return map;
+  }
+  size_t file_size( void) const
+  {
+    return size;
+  }
+
+private:
+  const uint32_t * next_compressed( void);
+
+  const uint8_t * map;
+  size_t mapped_size;
+  size_t size;			//!< valid bytes
+  char filename[256];
+  const uint8_t * data;		//!< first record or block
+  const uint8_t * position;
+  const uint8_t * end;
+  const log_header_t * file_header;
+  unsigned words;
+  bool compressed;
+  uint64_t record_number;
+  log_quantization quantization;
+  log_block_decoder decoder;
+  uint32_t record[LOG_RECORD_WORDS]; //!< decoded record
+};
+
+#endif /* HOST_TOOLS_LOG_READER_H_ */
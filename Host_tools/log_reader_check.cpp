@@ -0,0 +1,216 @@
+/** ***********************************************************************
+ * @file		log_reader_check.cpp
+ * @brief		host check and benchmark: log_reader on all log formats
+ *
+ * Without arguments a synthetic flight is written as legacy .f50, as .h50
+ * (header + raw) and as .c50 (header + compressed) into /tmp.
+ * All three are read back with log_reader: same record count, values
+ * found by channel name equal (compressed: within half a quantum), header
+ * skipped. Then the reading speed is measured.
+ * With a file argument only the speed of that file is measured.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom log_reader_check.cpp log_reader.cpp ../Drivers/Custom/log_compression.cpp
+ * ./a.out [log file]
+ **************************************************************************/
+
+#include "log_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define RECORDS 360000 // one hour @ 100 Hz
+
+static const log_channel_descriptor_t channels[] =
+{
+    { "acc",		0,   LOG_FLOAT32, 3, 1e-3f },
+    { "gyro",		12,  LOG_FLOAT32, 3, 1e-5f },
+    { "static_pressure",24,  LOG_FLOAT32, 1, 1e-2f },
+    { "velocity",	28,  LOG_FLOAT32, 3, 1e-3f },
+    { "other",		40,  LOG_FLOAT32, 30, 1e-3f },
+    { "latitude",	160, LOG_FLOAT64, 1, 0.0f },
+    { "longitude",	168, LOG_FLOAT64, 1, 0.0f },
+    { "second",		176, LOG_UINT8,   1, 0.0f },
+    { "nano",		180, LOG_INT32,   1, 0.0f },
+    { "spare",		184, LOG_UINT32,  4, 0.0f },
+};
+
+volatile double benchmark_sink;
+
+static double now( void)
+{
+  timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+static void make_record( unsigned n, uint32_t * record)
+{
+  memset( record, 0, LOG_RECORD_WORDS * sizeof( uint32_t));
+  float f[40];
+  for( unsigned i = 0; i < 40; ++i)
+    f[i] = 100.0f * sinf( 1e-3f * n * (i + 1)) + i;
+  f[6] = 101325.0f - 0.1f * n;
+  if( n % 10000 < 500)
+    f[7] = f[8] = f[9] = NAN; // no GNSS fix
+  memcpy( record, f, sizeof( f));
+  double latitude = 50.0 + 1e-7 * n, longitude = 8.0 - 1e-7 * n;
+  memcpy( (uint8_t *)record + 160, &latitude, sizeof( double));
+  memcpy( (uint8_t *)record + 168, &longitude, sizeof( double));
+  ((uint8_t *)record)[176] = (n / 100) % 60;
+  int32_t nano = (n % 100) * 10000000;
+  memcpy( (uint8_t *)record + 180, &nano, sizeof( nano));
+}
+
+static void write_header( FILE * file, log_record_format_t format)
+{
+  static uint8_t block[LOG_HEADER_SIZE];
+  memset( block, 0, sizeof( block));
+  log_header_t * header = (log_header_t *)block;
+  header->magic = LOG_HEADER_MAGIC;
+  header->version = LOG_HEADER_VERSION;
+  header->header_size = LOG_HEADER_SIZE;
+  header->record_size = LOG_RECORD_WORDS * sizeof( uint32_t);
+  header->sample_rate = 100;
+  header->format = format;
+  header->channel_count = sizeof( channels) / sizeof( channels[0]);
+  strcpy( header->firmware, "log_reader_check");
+  memcpy( (void *)get_log_channels( header), channels, sizeof( channels));
+  fwrite( block, 1, sizeof( block), file);
+}
+
+static void write_files( void)
+{
+  FILE * legacy = fopen( "/tmp/log_reader_check.f50", "wb");
+  FILE * raw = fopen( "/tmp/log_reader_check.h50", "wb");
+  FILE * packed = fopen( "/tmp/log_reader_check.c50", "wb");
+  write_header( raw, LOG_FORMAT_RAW);
+  write_header( packed, LOG_FORMAT_COMPRESSED);
+
+  log_quantization quantization( channels, sizeof( channels) / sizeof( channels[0]));
+  uint8_t block[LOG_COMPRESSED_BLOCK_SIZE];
+  log_block_encoder encoder( block, quantization);
+  uint32_t record[LOG_RECORD_WORDS];
+  for( unsigned n = 0; n < RECORDS; )
+    {
+      make_record( n, record);
+      if( encoder.append( record))
+	{
+	  fwrite( record, sizeof( record), 1, legacy);
+	  fwrite( record, sizeof( record), 1, raw);
+	  ++n;
+	  continue;
+	}
+      encoder.finish();
+      fwrite( block, 1, sizeof( block), packed);
+      encoder.start();
+    }
+  encoder.finish();
+  fwrite( block, 1, sizeof( block), packed);
+  fclose( legacy);
+  fclose( raw);
+  fclose( packed);
+}
+
+//! compare against the generator, @return mismatches
+static unsigned check( const char * filename)
+{
+  log_reader reader;
+  if( ! reader.open( filename))
+    {
+      printf( "%s: open failed\n", filename);
+      return 1;
+    }
+
+  // legacy files have no schema: use the generator's
+  const log_channel_descriptor_t * pressure = reader.channel( "static_pressure");
+  const log_channel_descriptor_t * velocity = reader.channel( "velocity");
+  const log_channel_descriptor_t * second = reader.channel( "second");
+  if( reader.header() == 0)
+    {
+      pressure = &channels[2];
+      velocity = &channels[3];
+      second = &channels[7];
+    }
+  if( ! pressure || ! velocity || ! second)
+    {
+      printf( "%s: channel missing\n", filename);
+      return 1;
+    }
+
+  unsigned mismatches = 0;
+  uint32_t expected[LOG_RECORD_WORDS];
+  const uint32_t * record;
+  while( (record = reader.next()) != 0)
+    {
+      unsigned n = reader.record_index() - 1;
+      make_record( n, expected);
+      double p = log_reader::value( record, pressure);
+      double v = log_reader::value( record, velocity, 1);
+      double v_expected = log_reader::value( expected, velocity, 1);
+      if(    fabs( p - log_reader::value( expected, pressure)) > 0.5 * pressure->quantum + 0.01
+	  || isnan( v) != isnan( v_expected)
+	  || ( ! isnan( v) && fabs( v - v_expected) > 0.5 * velocity->quantum + 1e-4)
+	  || log_reader::value( record, second) != log_reader::value( expected, second))
+	if( mismatches++ < 5)
+	  printf( "%s: record %u differs\n", filename, n);
+    }
+  if( reader.record_index() != RECORDS)
+    {
+      printf( "%s: %llu records instead of %u\n", filename, (unsigned long long)reader.record_index(), RECORDS);
+      ++mismatches;
+    }
+  return mismatches;
+}
+
+static void benchmark( const char * filename)
+{
+  log_reader reader;
+  if( ! reader.open( filename))
+    {
+      printf( "%s: open failed\n", filename);
+      return;
+    }
+  const log_channel_descriptor_t * pressure = reader.channel( "static_pressure");
+
+  double sum = 0.0;
+  double start = now();
+  unsigned passes = 0;
+  do
+    {
+      reader.rewind();
+      const uint32_t * record;
+      while( (record = reader.next()) != 0)
+	sum += pressure ? log_reader::value( record, pressure) : record[0];
+      ++passes;
+    }
+  while( now() - start < 1.0);
+  double seconds = now() - start;
+
+  benchmark_sink = sum; // keep the loop
+  printf( "%-32s %8.1f M records/s %8.0f MB/s file\n", filename,
+	  passes * reader.record_index() / seconds * 1e-6,
+	  passes * reader.file_size() / seconds * 1e-6);
+}
+
+int main( int argc, char ** argv)
+{
+  if( argc > 1)
+    {
+      for( int i = 1; i < argc; ++i)
+	benchmark( argv[i]);
+      return 0;
+    }
+
+  write_files();
+  const char * files[] = { "/tmp/log_reader_check.f50", "/tmp/log_reader_check.h50", "/tmp/log_reader_check.c50" };
+  unsigned mismatches = 0;
+  for( const char * file : files)
+    mismatches += check( file);
+  for( const char * file : files)
+    benchmark( file);
+
+  printf( "%s: %u mismatches\n", mismatches ? "FAILED" : "passed", mismatches);
+  return mismatches ? 1 : 0;
+}
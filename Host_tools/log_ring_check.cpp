@@ -0,0 +1,204 @@
+/** ***********************************************************************
+ * @file		log_ring_check.cpp
+ * @brief		host check: logger ring against a block device with latency spikes
+ *
+ * The communicator side mirrors sync_logger (), the logger side the raw
+ * (.h50) write loop of data_logger_runnable (): blocks are written from
+ * the ring in place and released afterwards, notifications coalesce.
+ * The simulated card needs SD_BLOCK_USEC per block and SD_SYNC_USEC for
+ * f_sync () and the index flush every 16 blocks. On top, spikes are
+ * injected into single block writes:
+ * - one hour with 50 .. 250 ms spikes, at least one second apart:
+ *   no record may be lost,
+ * - one spike of the 400 ms the ring is said to cover: no record lost,
+ * - one spike of 600 ms: the records lost must be counted in
+ *   dropped_records, the others must arrive.
+ * The block contents are taken at the end of each write, as the DMA
+ * may read them that late: every record arriving must be intact and in
+ * order, max_write_latency_us must match the longest write.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Core/Inc log_ring_check.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "data_logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define RECORD_SIZE		(50 * 4)	// LOG_RECORD_WORDS words, as SD_card_handler.cpp
+#define PERIOD_USEC		(1000000 / LOG_SAMPLE_RATE)
+#define SYNC_BLOCKS		16		// as data_logger_runnable ()
+#define SD_BLOCK_USEC		600.0
+#define SD_SYNC_USEC		4000.0
+#define WAKE_UP_USEC		50.0		// notification to logger running
+#define SPIKE_PROBABILITY	0.02
+#define MIN_SPIKE_USEC		50000.0
+#define MAX_SPIKE_USEC		250000.0
+#define SPIKE_SPACING_USEC	1000000.0
+#define COVERED_SPIKE_USEC	400000.0	// LOG_RING_BLOCKS comment
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+//! uniform in (0, 1)
+static double random_uniform( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return ((random_state * 0x2545f4914f6cdd1dULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+uint8_t log_ring[LOG_RING_SIZE];
+log_ring_state_t log_ring_state;
+
+static bool notified;
+
+//! as sync_logger (), the record holds its number in every word
+static void sync_logger( uint32_t record_number)
+{
+  uint32_t write_index = log_ring_state.write_index;
+  if( write_index - log_ring_state.read_index > LOG_RING_SIZE - RECORD_SIZE)
+    {
+      ++log_ring_state.dropped_records;
+      return;
+    }
+
+  uint32_t record[RECORD_SIZE / 4];
+  for( uint32_t & word : record)
+    word = record_number;
+
+  uint32_t offset = write_index % LOG_RING_SIZE;
+  uint32_t first_part = LOG_RING_SIZE - offset;
+  if( first_part > RECORD_SIZE)
+    first_part = RECORD_SIZE;
+  memcpy( log_ring + offset, record, first_part);
+  memcpy( log_ring, (uint8_t *)record + first_part, RECORD_SIZE - first_part);
+
+  log_ring_state.write_index = write_index + RECORD_SIZE;
+  if( (write_index % LOG_BLOCK_SIZE) + RECORD_SIZE >= LOG_BLOCK_SIZE)
+    notified = true;
+}
+
+struct run_result
+{
+  uint32_t produced;
+  uint32_t received;
+  uint32_t damaged;	//!< records not intact or out of order
+  uint32_t missing;	//!< gaps in the record numbers
+  double max_latency_usec;
+};
+
+/*! simulate the given time
+ * @param long_spike_usec	one spike of this length after half the time, 0 = none
+ */
+static run_result run( double duration_usec, double long_spike_usec)
+{
+  memset( &log_ring_state, 0, sizeof( log_ring_state));
+  notified = false;
+  std::vector<uint8_t> file;
+
+  bool writing = false;
+  double write_end = 0.0, logger_free = 0.0, last_spike = -SPIKE_SPACING_USEC;
+  unsigned sync_counter = 0;
+  run_result result = { 0, 0, 0, 0, 0.0};
+
+  for( double tick = PERIOD_USEC; tick < duration_usec; tick += PERIOD_USEC)
+    {
+      // logger: everything happening before this communicator cycle
+      while( true)
+	{
+	  if( writing)
+	    {
+	      if( write_end > tick)
+		break;
+	      // DMA done: block contents as of now
+	      const uint8_t * block = log_ring + (log_ring_state.read_index % LOG_RING_SIZE);
+	      file.insert( file.end(), block, block + LOG_BLOCK_SIZE);
+	      log_ring_state.read_index += LOG_BLOCK_SIZE; // release_log_block ()
+	      writing = false;
+	      logger_free = write_end;
+	    }
+	  if( log_ring_state.write_index - log_ring_state.read_index >= LOG_BLOCK_SIZE) // next_log_block ()
+	    {
+	      double latency = SD_BLOCK_USEC;
+	      if( ++sync_counter >= SYNC_BLOCKS)
+		{
+		  latency += SD_SYNC_USEC;
+		  sync_counter = 0;
+		}
+	      if( long_spike_usec > 0.0 && logger_free > duration_usec / 2)
+		{
+		  latency += long_spike_usec;
+		  long_spike_usec = 0.0;
+		}
+	      else if( logger_free - last_spike > SPIKE_SPACING_USEC && random_uniform() < SPIKE_PROBABILITY)
+		{
+		  latency += MIN_SPIKE_USEC + (MAX_SPIKE_USEC - MIN_SPIKE_USEC) * random_uniform();
+		  last_spike = logger_free;
+		}
+	      if( latency > log_ring_state.max_write_latency_us)
+		log_ring_state.max_write_latency_us = (uint32_t)latency;
+	      result.max_latency_usec = latency > result.max_latency_usec ? latency : result.max_latency_usec;
+	      write_end = logger_free + latency;
+	      writing = true;
+	      continue;
+	    }
+	  if( ! notified) // notify_take ()
+	    break;
+	  notified = false;
+	  logger_free = tick - PERIOD_USEC + WAKE_UP_USEC > logger_free ? tick - PERIOD_USEC + WAKE_UP_USEC : logger_free;
+	}
+
+      sync_logger( result.produced++);
+    }
+
+  // the file: whole records, increasing numbers, each record intact
+  int64_t previous = -1;
+  for( size_t position = 0; position + RECORD_SIZE <= file.size(); position += RECORD_SIZE)
+    {
+      uint32_t record[RECORD_SIZE / 4];
+      memcpy( record, &file[position], RECORD_SIZE);
+      bool intact = (int64_t)record[0] > previous;
+      for( uint32_t word : record)
+	intact = intact && word == record[0];
+      if( ! intact)
+	++result.damaged;
+      else
+	result.missing += record[0] - previous - 1;
+      previous = record[0];
+      ++result.received;
+    }
+  return result;
+}
+
+int main( void)
+{
+  unsigned failures = 0;
+
+  run_result spikes = run( 3600e6, 0.0);
+  printf( "spikes up to %.0f ms: %u records, %u dropped, %u received, %u damaged, max latency %.1f ms\n",
+	  MAX_SPIKE_USEC * 1e-3, spikes.produced, log_ring_state.dropped_records, spikes.received, spikes.damaged,
+	  log_ring_state.max_write_latency_us * 1e-3);
+  if( log_ring_state.dropped_records != 0 || spikes.damaged != 0 || spikes.missing != 0
+      || spikes.received < spikes.produced - LOG_RING_SIZE / RECORD_SIZE
+      || log_ring_state.max_write_latency_us != (uint32_t)spikes.max_latency_usec)
+    ++failures;
+
+  // one spike within and one beyond the coverage stated in data_logger.h
+  const double long_spikes[] = { COVERED_SPIKE_USEC, 1.5 * COVERED_SPIKE_USEC};
+  for( double long_spike : long_spikes)
+    {
+      run_result overload = run( 60e6, long_spike);
+      printf( "one %.0f ms spike: %u records, %u dropped, %u missing, %u received, %u damaged\n", long_spike * 1e-3,
+	      overload.produced, log_ring_state.dropped_records, overload.missing, overload.received, overload.damaged);
+      bool covered = long_spike <= COVERED_SPIKE_USEC;
+      if( (log_ring_state.dropped_records == 0) != covered || log_ring_state.dropped_records != overload.missing
+	  || overload.damaged != 0)
+	++failures;
+    }
+
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
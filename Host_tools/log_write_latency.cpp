@@ -0,0 +1,397 @@
+/** ***********************************************************************
+ * @file		log_write_latency.cpp
+ * @brief		host benchmark: log file write latency, growing vs. preallocated
+ *
+ * The firmware's FatFs runs on a 4 GB RAM disk (FAT32, 32 kB clusters) with a
+ * simple SD card timing model: every command costs SD_COMMAND_USEC, every
+ * sector SD_SECTOR_USEC, and a write not continuing the previous one
+ * SD_JUMP_USEC on top (the card's read-modify-write of an allocation unit).
+ * The card is fragmented first: old files with every other one deleted and
+ * the next-free hint unknown, as written by a PC.
+ * Then 30 minutes of the logger are replayed: 2048 byte blocks, f_sync ()
+ * and index flush every 16 blocks, a *.TIM line each minute and a new *.mcl
+ * file every three minutes. Reported is the log write time (f_write (),
+ * f_sync () and index flush, as max_write_latency_us) and the worst time
+ * from one block to the next including the side files, for
+ *   growing:       no preallocation, state before the change
+ *   prepared:      f_expand (..., 0), only the allocation start point is set
+ *   preallocated:  index file first, f_expand (..., 1), size kept in the index
+ * After each run the power is cut, the volume mounted again and the logs
+ * cut like truncate_interrupted_logs () does. The FAT must not show lost
+ * clusters then and the log must have its synchronized size.
+ *
+ * Not part of the firmware, build and run on the host:
+ * gcc -O2 -c -Ifatfs ../Middlewares/Third_Party/FatFs/src/ff.c ../Middlewares/Third_Party/FatFs/src/option/ccsbcs.c
+ * g++ -O2 -Ifatfs -I../Middlewares/Third_Party/FatFs/src -I../Drivers/Custom -I../Core/Inc log_write_latency.cpp ff.o ccsbcs.o
+ * ./a.out
+ **************************************************************************/
+
+#include "ff.h"
+#include "diskio.h"
+#include "log_format.h"
+#include "data_logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <vector>
+#include <algorithm>
+
+#define SECTOR_SIZE		512
+#define DISK_SECTORS		(4ULL * 1024 * 1024 * 1024 / SECTOR_SIZE)
+#define CLUSTER_SIZE		32768
+
+#define SD_COMMAND_USEC		150.0
+#define SD_SECTOR_USEC		40.0	// about 12 MB/s on the 4 bit bus
+#define SD_JUMP_USEC		2500.0
+
+#define RECORD_SIZE		200	// 50 floats
+#define LOG_SECONDS		1800
+#define OLD_FILES		1500
+#define OLD_FILE_SIZE		(2 * CLUSTER_SIZE)
+
+static uint8_t * disk;
+static double disk_time_usec;
+static DWORD next_sequential_sector;
+static DWORD fat_start, fat_end;	// sector range of the FATs
+static unsigned fat_writes, jumps;
+
+extern "C"
+{
+DSTATUS disk_initialize( BYTE)
+{
+  return 0;
+}
+
+DSTATUS disk_status( BYTE)
+{
+  return 0;
+}
+
+DRESULT disk_read( BYTE, BYTE * buffer, DWORD sector, UINT count)
+{
+  memcpy( buffer, disk + (uint64_t)sector * SECTOR_SIZE, count * SECTOR_SIZE);
+  disk_time_usec += SD_COMMAND_USEC + count * SD_SECTOR_USEC;
+  return RES_OK;
+}
+
+DRESULT disk_write( BYTE, const BYTE * buffer, DWORD sector, UINT count)
+{
+  memcpy( disk + (uint64_t)sector * SECTOR_SIZE, buffer, count * SECTOR_SIZE);
+  disk_time_usec += SD_COMMAND_USEC + count * SD_SECTOR_USEC;
+  if( sector != next_sequential_sector)
+    {
+      disk_time_usec += SD_JUMP_USEC;
+      ++jumps;
+    }
+  next_sequential_sector = sector + count;
+  if( sector >= fat_start && sector < fat_end)
+    ++fat_writes;
+  return RES_OK;
+}
+
+DRESULT disk_ioctl( BYTE, BYTE command, void * buffer)
+{
+  switch( command)
+    {
+    case GET_SECTOR_COUNT:
+      *(DWORD *)buffer = DISK_SECTORS;
+      break;
+    case GET_SECTOR_SIZE:
+      *(WORD *)buffer = SECTOR_SIZE;
+      break;
+    case GET_BLOCK_SIZE:
+      *(DWORD *)buffer = 8192; // 4 MB allocation unit
+      break;
+    }
+  return RES_OK;
+}
+
+DWORD get_fattime( void)
+{
+  return ((2026 - 1980) << 25) | (1 << 21) | (1 << 16);
+}
+} // extern "C"
+
+static FATFS fatfs;
+
+static void mount( void)
+{
+  f_mount( 0, "", 0);
+  f_mount( &fatfs, "", 1);
+  fat_start = fatfs.fatbase;
+  fat_end = fatfs.database;
+}
+
+//! FAT32 entry read directly from the disk image
+static DWORD fat_entry( DWORD cluster)
+{
+  DWORD entry;
+  memcpy( &entry, disk + (uint64_t)fatfs.fatbase * SECTOR_SIZE + cluster * 4, sizeof( entry));
+  return entry & 0x0FFFFFFF;
+}
+
+//! formatted card with old files, every other one deleted, next-free hint unknown
+static void prepare_card( void)
+{
+  static uint8_t work[_MAX_SS];
+  memset( disk, 0, 64 * 1024 * 1024); // boot sector, FATs and root directory
+  f_mkfs( "", FM_FAT32 | FM_SFD, CLUSTER_SIZE, work, sizeof( work));
+  mount();
+
+  static uint8_t data[OLD_FILE_SIZE];
+  for( unsigned i = 0; i < OLD_FILES; ++i)
+    {
+      char name[16];
+      snprintf( name, sizeof( name), "OLD%04u.DAT", i);
+      FIL file;
+      UINT written;
+      f_open( &file, name, FA_CREATE_ALWAYS | FA_WRITE);
+      f_write( &file, data, sizeof( data), &written);
+      f_close( &file);
+    }
+  for( unsigned i = 0; i < OLD_FILES; i += 2)
+    {
+      char name[16];
+      snprintf( name, sizeof( name), "OLD%04u.DAT", i);
+      f_unlink( name);
+    }
+  f_mount( 0, "", 0);
+
+  // FSINFO: next free cluster unknown
+  DWORD fsinfo_sector = disk[48] | (disk[49] << 8);
+  memset( disk + fsinfo_sector * SECTOR_SIZE + 492, 0xff, 4);
+  mount();
+}
+
+enum preallocation_t { GROWING, PREPARED, PREALLOCATED };
+
+struct result_t
+{
+  std::vector<double> latency_usec;	//!< block write, sync and index flush
+  double max_cycle_usec;		//!< including the side files
+  unsigned fat_writes;
+  unsigned jumps;
+  unsigned fragments;
+  unsigned lost_clusters;
+  bool size_ok;
+};
+
+static FIL log_file, index_file;
+static log_index_header_t index_header = { LOG_INDEX_MAGIC, LOG_INDEX_VERSION, sizeof( log_index_entry_t), 0};
+
+static void open_index_file( const char * log_name)
+{
+  char name[64];
+  snprintf( name, sizeof( name), "%s.IDX", log_name);
+  UINT written;
+  f_open( &index_file, name, FA_CREATE_ALWAYS | FA_WRITE);
+  f_write( &index_file, &index_header, sizeof( index_header), &written);
+}
+
+static void flush_index( preallocation_t mode, const log_index_entry_t * entries, unsigned count)
+{
+  UINT written;
+  if( count > 0)
+    f_write( &index_file, entries, count * sizeof( log_index_entry_t), &written);
+  if( mode == PREALLOCATED)
+    {
+      FSIZE_t index_size = f_tell( &index_file);
+      index_header.data_size = f_tell( &log_file);
+      f_lseek( &index_file, 0);
+      f_write( &index_file, &index_header, sizeof( index_header), &written);
+      f_lseek( &index_file, index_size);
+    }
+  f_sync( &index_file);
+}
+
+static void append_line( const char * name, bool create)
+{
+  FIL file;
+  UINT written;
+  static const char line[] = "ADC supply 5.02 V VDDA 3.301 V CPU 41.5 C\r\n";
+  if( f_open( &file, name, create ? FA_CREATE_ALWAYS | FA_WRITE : FA_OPEN_APPEND | FA_WRITE) != FR_OK)
+    return;
+  f_write( &file, line, sizeof( line) - 1, &written);
+  f_close( &file);
+}
+
+//! as truncate_interrupted_logs () in SD_card_handler.cpp
+static void truncate_interrupted_logs( void)
+{
+  DIR directory;
+  FILINFO info;
+  if( f_opendir( &directory, "") != FR_OK)
+    return;
+  while( f_readdir( &directory, &info) == FR_OK && info.fname[0] != 0)
+    {
+      if( info.fsize != LOG_FILE_PREALLOCATION)
+	continue;
+      char name[_MAX_LFN + 5];
+      snprintf( name, sizeof( name), "%s.IDX", info.fname);
+      log_index_header_t header;
+      UINT bytesread;
+      if( f_open( &index_file, name, FA_READ) != FR_OK)
+	continue;
+      bool valid = f_read( &index_file, &header, sizeof( header), &bytesread) == FR_OK
+	  && bytesread == sizeof( header) && header.magic == LOG_INDEX_MAGIC
+	  && header.version == LOG_INDEX_VERSION && header.data_size < info.fsize;
+      f_close( &index_file);
+      if( valid && f_open( &index_file, info.fname, FA_WRITE) == FR_OK)
+	{
+	  if( f_lseek( &index_file, header.data_size) == FR_OK)
+	    f_truncate( &index_file);
+	  f_close( &index_file);
+	}
+    }
+  f_closedir( &directory);
+}
+
+//! clusters allocated on the FAT but not belonging to any file
+static unsigned lost_clusters( void)
+{
+  unsigned allocated = 0;
+  for( DWORD cluster = 2; cluster < fatfs.n_fatent; ++cluster)
+    if( fat_entry( cluster) != 0)
+      ++allocated;
+
+  unsigned referenced = 0;
+  for( DWORD cluster = fatfs.dirbase; cluster >= 2 && cluster < fatfs.n_fatent; cluster = fat_entry( cluster))
+    ++referenced; // root directory
+  DIR directory;
+  FILINFO info;
+  f_opendir( &directory, "");
+  while( f_readdir( &directory, &info) == FR_OK && info.fname[0] != 0)
+    referenced += (info.fsize + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+  f_closedir( &directory);
+  return allocated - referenced;
+}
+
+static unsigned fragments( DWORD start_cluster)
+{
+  unsigned count = start_cluster >= 2 ? 1 : 0;
+  for( DWORD cluster = start_cluster; cluster >= 2 && cluster < fatfs.n_fatent; )
+    {
+      DWORD next = fat_entry( cluster);
+      if( next >= 2 && next < fatfs.n_fatent && next != cluster + 1)
+	++count;
+      cluster = next;
+    }
+  return count;
+}
+
+static result_t run( preallocation_t mode)
+{
+  prepare_card();
+  result_t result;
+  result.max_cycle_usec = 0.0;
+  const char * log_name = "20260101120000.h50";
+  UINT written;
+
+  f_open( &log_file, log_name, FA_CREATE_ALWAYS | FA_WRITE);
+  if( mode == PREALLOCATED)
+    open_index_file( log_name);
+  if( mode != GROWING && f_expand( &log_file, LOG_FILE_PREALLOCATION, mode == PREALLOCATED) != FR_OK)
+    printf( "f_expand failed\n");
+  static uint8_t block[LOG_BLOCK_SIZE];
+  f_write( &log_file, block, LOG_HEADER_SIZE, &written);
+  if( mode != PREALLOCATED)
+    open_index_file( log_name);
+
+  disk_time_usec = 0.0;
+  fat_writes = jumps = 0;
+  const unsigned blocks = (uint64_t)LOG_SECONDS * LOG_SAMPLE_RATE * RECORD_SIZE / LOG_BLOCK_SIZE;
+  const double block_seconds = (double)LOG_BLOCK_SIZE / RECORD_SIZE / LOG_SAMPLE_RATE;
+  log_index_entry_t entries[LOG_INDEX_BUFFER_ENTRIES];
+  unsigned index_entries = 0;
+  double next_index_time = 0.0, next_report_time = 60.0, next_calibration_time = 180.0;
+  unsigned sync_counter = 0;
+
+  for( unsigned n = 0; n < blocks; ++n)
+    {
+      double start = disk_time_usec;
+      double time = n * block_seconds;
+      if( time >= next_index_time && index_entries < LOG_INDEX_BUFFER_ENTRIES)
+	{
+	  entries[index_entries++] = { (uint32_t)(time * 1000), (uint32_t)(time * LOG_SAMPLE_RATE), (uint32_t)f_tell( &log_file)};
+	  next_index_time += LOG_INDEX_INTERVAL;
+	}
+      memset( block, n, sizeof( block));
+      f_write( &log_file, block, sizeof( block), &written);
+      if( ++sync_counter >= 16)
+	{
+	  sync_counter = 0;
+	  f_sync( &log_file);
+	  flush_index( mode, entries, index_entries);
+	  index_entries = 0;
+	}
+      result.latency_usec.push_back( disk_time_usec - start);
+      if( sync_counter == 0)
+	{
+	  if( time >= next_report_time)
+	    {
+	      append_line( "20260101120000.h50.TIM", false);
+	      next_report_time += 60.0;
+	    }
+	  if( time >= next_calibration_time)
+	    {
+	      char name[32];
+	      snprintf( name, sizeof( name), "260101_%06uM.mcl", (unsigned)time);
+	      append_line( name, true);
+	      next_calibration_time += 180.0;
+	    }
+	}
+      result.max_cycle_usec = std::max( result.max_cycle_usec, disk_time_usec - start);
+    }
+  result.fat_writes = fat_writes;
+  result.jumps = jumps;
+
+  // power cut: the open files are left as they are after the last sync
+  FSIZE_t synchronized_size = index_header.data_size;
+  if( mode != PREALLOCATED)
+    synchronized_size = f_tell( &log_file) - sync_counter * LOG_BLOCK_SIZE;
+  DWORD start_cluster = log_file.obj.sclust;
+  mount();
+  truncate_interrupted_logs();
+  result.lost_clusters = lost_clusters();
+  result.fragments = fragments( start_cluster);
+  FILINFO info;
+  result.size_ok = f_stat( log_name, &info) == FR_OK && info.fsize == synchronized_size;
+  f_mount( 0, "", 0);
+  return result;
+}
+
+int main( void)
+{
+  disk = (uint8_t *)mmap( 0, DISK_SECTORS * SECTOR_SIZE, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if( disk == MAP_FAILED)
+    {
+      perror( "RAM disk");
+      return 1;
+    }
+
+  const char * names[] = { "growing", "prepared", "preallocated" };
+  printf( "%-14s %8s %8s %8s %9s %10s %7s %9s %5s %5s\n", "mode", "mean ms", "99.9% ms", "max ms",
+	  "cycle ms", "FAT writes", "jumps", "fragments", "lost", "size");
+  unsigned failures = 0;
+  for( int mode = GROWING; mode <= PREALLOCATED; ++mode)
+    {
+      result_t result = run( (preallocation_t)mode);
+      std::vector<double> & latency = result.latency_usec;
+      double mean = 0.0;
+      for( double value : latency)
+	mean += value;
+      mean /= latency.size();
+      std::sort( latency.begin(), latency.end());
+      printf( "%-14s %8.2f %8.2f %8.2f %9.2f %10u %7u %9u %5u %5s\n", names[mode], mean * 1e-3,
+	      latency[latency.size() * 999 / 1000] * 1e-3, latency.back() * 1e-3, result.max_cycle_usec * 1e-3,
+	      result.fat_writes, result.jumps, result.fragments, result.lost_clusters,
+	      result.size_ok ? "ok" : "wrong");
+      if( result.lost_clusters != 0 || ! result.size_ok)
+	++failures;
+      if( mode == PREALLOCATED && result.fragments != 1)
+	++failures;
+    }
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+/** ***********************************************************************
+ * @file		pressure_prefilter_check.cpp
+ * @brief		host check: pressure pre-filter noise, spikes, step and ramp
+ *
+ * Input @ 100 Hz around 95 kPa, one temperature conversion gap per 10
+ * samples filled by hold () as i2c_sensors.cpp does:
+ * - white noise of 1.2 Pa rms (MS5611 @ OSR 4096) must leave below 0.7 Pa,
+ * - 60 Pa spikes on single samples must not pass,
+ * - a 12 Pa step (1 m) must settle with less than 7 % overshoot,
+ * - a 5 m/s climb must lag by the documented delay, the median plus
+ *   PRESSURE_BIQUAD_DELAY samples, within 0.05 samples.
+ * The time per sample is reported.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -I../Drivers/Custom pressure_prefilter_check.cpp ../Drivers/Custom/pressure_prefilter.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "pressure_prefilter.h"
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#define PRESSURE	95000.0f
+#define NOISE_RMS	1.2	// Pa
+#define SAMPLES		100000
+#define SETTLING	100
+#define GAP_PERIOD	10	// as MS5611_TEMPERATURE_DECIMATION
+
+#define DOCUMENTED_DELAY	((PRESSURE_MEDIAN_LENGTH - 1) / 2 + PRESSURE_BIQUAD_DELAY)
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+//! uniform in (0, 1)
+static double random_uniform( void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return ((random_state * 0x2545f4914f6cdd1dULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double random_gaussian( void)
+{
+  return sqrt( -2.0 * log( random_uniform())) * cos( 2.0 * M_PI * random_uniform());
+}
+
+static unsigned failures;
+
+static void expect( bool condition, const char * what, double value)
+{
+  if( condition)
+    return;
+  printf( "%s (%g)\n", what, value);
+  ++failures;
+}
+
+//! @return rms of the output deviation, worst deviation in *peak
+static double noise_response( double spike, double * peak)
+{
+  pressure_prefilter filter;
+  double sum = 0.0;
+  unsigned count = 0;
+  *peak = 0.0;
+  for( unsigned n = 0; n < SAMPLES; ++n)
+    {
+      if( n % GAP_PERIOD == GAP_PERIOD - 1)
+	{
+	  filter.hold();
+	  continue;
+	}
+      double x = NOISE_RMS * random_gaussian();
+      if( spike != 0.0 && n % 137 == 0)
+	x += spike;
+      double y = filter.feed( PRESSURE + (float)x) - PRESSURE;
+      if( n < SETTLING)
+	continue;
+      sum += y * y;
+      ++count;
+      *peak = fmax( *peak, fabs( y));
+    }
+  return sqrt( sum / count);
+}
+
+int main( void)
+{
+  double peak;
+  double rms = noise_response( 0.0, &peak);
+  printf( "noise: %.2f Pa rms in, %.2f Pa rms out, peak %.2f Pa\n", NOISE_RMS, rms, peak);
+  expect( rms < 0.7, "noise not reduced", rms);
+
+  double spiked_rms = noise_response( 60.0, &peak);
+  printf( "spikes: %.2f Pa rms out, peak %.2f Pa\n", spiked_rms, peak);
+  expect( peak < 6.0, "spikes pass the median", peak);
+
+  // step of 12 Pa
+  pressure_prefilter filter;
+  double step_peak = 0.0, step_end = 0.0;
+  for( unsigned n = 0; n < 200; ++n)
+    {
+      float y = filter.feed( n < 50 ? PRESSURE : PRESSURE - 12.0f) - PRESSURE;
+      step_peak = fmax( step_peak, -y);
+      step_end = -y;
+    }
+  printf( "step: 12 Pa, settled at %.3f Pa, overshoot %.1f %%\n", step_end, (step_peak / 12.0 - 1.0) * 100.0);
+  expect( fabs( step_end - 12.0) < 0.01, "step not settled", step_end);
+  expect( step_peak < 12.0 * 1.07, "step overshoot", step_peak);
+
+  // climb 5 m/s = 60 Pa/s
+  filter.reset();
+  const double slope = -0.6; // Pa per sample
+  double lag = 0.0;
+  for( unsigned n = 0; n < 500; ++n)
+    {
+      double x = PRESSURE + slope * n;
+      double y = filter.feed( (float)x);
+      lag = (x - y) / slope;
+    }
+  printf( "ramp: lag %.3f samples, documented %.3f\n", lag, (double)DOCUMENTED_DELAY);
+  expect( fabs( lag - DOCUMENTED_DELAY) < 0.05, "ramp lag differs from the documented delay", lag);
+
+  // time per sample
+  filter.reset();
+  volatile float sink = 0.0f;
+  clock_t start = clock();
+  for( unsigned n = 0; n < 10 * SAMPLES; ++n)
+    sink = filter.feed( PRESSURE + (float)(n & 7));
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  (void)sink;
+  printf( "%.1f ns per sample on the host\n", seconds / (10.0 * SAMPLES) * 1e9);
+
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+/** ***********************************************************************
+ * @file		seqlock_check.cpp
+ * @brief		host check: seqlock and seqlocked slot under concurrent access
+ *
+ * One writer thread publishes records of 16 words, all words equal to a
+ * running counter, as fast as it can. Three reader threads read them,
+ * two by seqlocked::try_read () as the communicator latches the sensor
+ * slots, one by the read_begin () / read_retry () loop as the output
+ * tasks read output_data. Every record accepted by a reader must be
+ * consistent and the counters seen by one reader must not go backwards.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -pthread -Ishims -I../Core/Inc seqlock_check.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "seqlock.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+#define WORDS		16
+#define PUBLICATIONS	20000000
+#define READERS		3
+
+struct record_t
+{
+  uint32_t word[WORDS];
+};
+
+static seqlocked<record_t> slot;
+
+static seqlock_t lock;
+static record_t locked_record;
+
+static std::atomic<bool> writer_done( false);
+
+struct reader_result
+{
+  uint64_t reads = 0;
+  uint64_t rejected = 0;
+  uint64_t torn = 0;
+  uint64_t backwards = 0;
+};
+
+static void writer( void)
+{
+  record_t record;
+  for( uint32_t n = 1; n <= PUBLICATIONS; ++n)
+    {
+      for( unsigned i = 0; i < WORDS; ++i)
+	record.word[i] = n;
+      slot.publish( record);
+
+      lock.write_begin();
+      locked_record = record;
+      lock.write_end();
+    }
+  writer_done = true;
+}
+
+static void check( const record_t & record, uint32_t & latest, reader_result & result)
+{
+  ++result.reads;
+  for( unsigned i = 1; i < WORDS; ++i)
+    if( record.word[i] != record.word[0])
+      {
+	++result.torn;
+	return;
+      }
+  if( record.word[0] < latest)
+    ++result.backwards;
+  latest = record.word[0];
+}
+
+static void slot_reader( reader_result * result)
+{
+  uint32_t latest = 0;
+  record_t record;
+  while( ! writer_done)
+    if( slot.try_read( record))
+      check( record, latest, *result);
+    else
+      ++result->rejected;
+}
+
+static void lock_reader( reader_result * result)
+{
+  uint32_t latest = 0;
+  record_t record;
+  while( ! writer_done)
+    {
+      uint32_t sequence;
+      do
+	{
+	  sequence = lock.read_begin();
+	  record = locked_record;
+	  if( lock.read_retry( sequence))
+	    ++result->rejected;
+	}
+      while( lock.read_retry( sequence));
+      if( sequence != 0)
+	check( record, latest, *result);
+    }
+}
+
+int main( void)
+{
+  reader_result results[READERS];
+  std::thread readers[READERS] =
+    {
+      std::thread( slot_reader, &results[0]),
+      std::thread( slot_reader, &results[1]),
+      std::thread( lock_reader, &results[2]),
+    };
+  std::thread write( writer);
+  write.join();
+  for( std::thread & reader : readers)
+    reader.join();
+
+  unsigned failures = 0;
+  for( unsigned r = 0; r < READERS; ++r)
+    {
+      printf( "reader %u: %llu records, %llu retries, %llu torn, %llu backwards\n", r,
+	      (unsigned long long)results[r].reads, (unsigned long long)results[r].rejected,
+	      (unsigned long long)results[r].torn, (unsigned long long)results[r].backwards);
+      if( results[r].torn || results[r].backwards || results[r].reads == 0)
+	++failures;
+    }
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+/** ***********************************************************************
+ * @file		FreeRTOS_wrapper.h
+ * @brief		host replacement of the FreeRTOS wrapper, threads instead of tasks
+ *
+ * Only what the host checks of the inter-task primitives need.
+ **************************************************************************/
+
+#ifndef HOST_FREERTOS_WRAPPER_H
+#define HOST_FREERTOS_WRAPPER_H
+
+#include <thread>
+
+typedef unsigned TickType_t;
+
+//! give the other threads a chance, ticks are not simulated
+inline void delay( TickType_t)
+{
+  std::this_thread::yield();
+}
+
+#endif /* HOST_FREERTOS_WRAPPER_H */
@@ -0,0 +1,15 @@
+/** ***********************************************************************
+ * @file		cmsis_compiler.h
+ * @brief		host replacement of the CMSIS compiler intrinsics
+ *
+ * __DMB () becomes a full fence for the host compiler and CPU.
+ **************************************************************************/
+
+#ifndef HOST_CMSIS_COMPILER_H
+#define HOST_CMSIS_COMPILER_H
+
+#include <atomic>
+
+#define __DMB()	std::atomic_thread_fence( std::memory_order_seq_cst)
+
+#endif /* HOST_CMSIS_COMPILER_H */
@@ -0,0 +1,112 @@
+/** ***********************************************************************
+ * @file		spsc_ring_check.cpp
+ * @brief		host check: spsc_ring with a producer and a consumer thread
+ *
+ * The producer pushes one million numbered entries of 32 bytes into a ring
+ * of 16, the consumer pops them, both pausing at random. Entries dropped
+ * on a full ring are counted by the producer, which yields then. The consumer must receive
+ * every entry that has been accepted, in order, unmodified, and the
+ * overrun counter must match the drops.
+ *
+ * Not part of the firmware, build and run on the host:
+ * g++ -O2 -pthread -Ishims -I../Core/Inc spsc_ring_check.cpp
+ * ./a.out
+ **************************************************************************/
+
+#include "spsc_ring.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#define ENTRIES		1000000
+#define RING_SIZE	16
+
+struct entry_t
+{
+  uint64_t number;
+  uint64_t square;
+  uint64_t inverted;
+  uint64_t sum;
+};
+
+static spsc_ring<entry_t, RING_SIZE> ring;
+static std::atomic<bool> producer_done( false);
+static uint64_t dropped;
+
+//! xorshift, one state per thread
+static uint32_t random_bits( uint64_t & state)
+{
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return (uint32_t)((state * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static void producer( void)
+{
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  for( uint64_t n = 1; n <= ENTRIES; ++n)
+    {
+      entry_t entry = { n, n * n, ~n, 0};
+      entry.sum = entry.number + entry.square + entry.inverted;
+      if( ! ring.push( entry))
+	{
+	  ++dropped;
+	  std::this_thread::sleep_for( std::chrono::microseconds( 10)); // let the consumer catch up
+	}
+      else if( random_bits( state) % 1024 == 0)
+	std::this_thread::yield();
+    }
+  producer_done = true;
+}
+
+int main( void)
+{
+  std::thread produce( producer);
+
+  uint64_t state = 0x2545f4914f6cdd1dULL;
+  uint64_t received = 0, corrupted = 0, disordered = 0, latest = 0;
+  entry_t entry;
+  while( true)
+    {
+      bool done = producer_done; // read before the final pop attempt
+      if( ! ring.pop( entry))
+	{
+	  if( done)
+	    break;
+	  continue;
+	}
+      ++received;
+      if( entry.square != entry.number * entry.number || entry.inverted != ~entry.number
+	  || entry.sum != entry.number + entry.square + entry.inverted)
+	++corrupted;
+      else if( entry.number <= latest)
+	++disordered;
+      else
+	latest = entry.number;
+      if( random_bits( state) % 1024 == 0)
+	std::this_thread::yield();
+    }
+  produce.join();
+
+  unsigned failures = 0;
+  if( corrupted || disordered)
+    {
+      printf( "%llu corrupted, %llu out of order\n", (unsigned long long)corrupted, (unsigned long long)disordered);
+      ++failures;
+    }
+  if( received + dropped != ENTRIES)
+    {
+      printf( "%llu received + %llu dropped != %u pushed\n", (unsigned long long)received, (unsigned long long)dropped, ENTRIES);
+      ++failures;
+    }
+  if( ring.overruns != dropped)
+    {
+      printf( "overrun counter %u, %llu dropped\n", ring.overruns, (unsigned long long)dropped);
+      ++failures;
+    }
+  printf( "%llu received, %llu dropped on a full ring\n", (unsigned long long)received, (unsigned long long)dropped);
+  printf( "%s: %u failures\n", failures ? "FAILED" : "passed", failures);
+  return failures ? 1 : 0;
+}
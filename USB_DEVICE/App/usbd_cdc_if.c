@@ -110,6 +110,7 @@ uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 extern USBD_HandleTypeDef hUsbDeviceFS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
+void (*CDC_transmit_complete_handler)(void) = NULL; //!< called from the USB ISR
 
 /* USER CODE END EXPORTED_VARIABLES */
 
@@ -312,6 +313,8 @@ static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
   UNUSED(Buf);
   UNUSED(Len);
   UNUSED(epnum);
+  if (CDC_transmit_complete_handler)
+    CDC_transmit_complete_handler();
   /* USER CODE END 13 */
   return result;
 }
@@ -95,7 +95,7 @@
 extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
-
+extern void (*CDC_transmit_complete_handler)(void);
 /* USER CODE END EXPORTED_VARIABLES */
 
 /**
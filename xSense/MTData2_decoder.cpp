@@ -0,0 +1,105 @@
+/** ***********************************************************************
+ * @file		MTData2_decoder.cpp
+ * @brief		table-driven decoder for Xsens MTData2 measurement messages
+ **************************************************************************/
+
+#include "MTData2_decoder.h"
+#include "xbusmessageid.h"
+#include "xbushelpers.h"
+#include "stddef.h"
+
+enum packet_format_t { FLOAT32, UINT16, UINT32 };
+
+typedef struct
+{
+  uint16_t data_id;
+  uint8_t format;
+  uint8_t count;	//!< number of elements
+  uint16_t offset;	//!< target within MTData2_t
+  uint16_t flag;
+} packet_descriptor_t;
+
+static constexpr packet_descriptor_t packets[] =
+{
+    { XDI_PACKET_COUNTER,	UINT16,  1, offsetof( MTData2_t, packet_counter),	MTDATA2_PACKET_COUNTER},
+    { XDI_SAMPLE_TIME_FINE,	UINT32,  1, offsetof( MTData2_t, sample_time_fine),	MTDATA2_SAMPLE_TIME_FINE},
+    { XDI_QUATERNION,		FLOAT32, 4, offsetof( MTData2_t, quaternion),		MTDATA2_QUATERNION},
+    { XDI_DELTA_V,		FLOAT32, 3, offsetof( MTData2_t, delta_v),		MTDATA2_DELTA_V},
+    { XDI_ACCELERATION,		FLOAT32, 3, offsetof( MTData2_t, acc),			MTDATA2_ACCELERATION},
+    { XDI_RATE_OF_TURN,		FLOAT32, 3, offsetof( MTData2_t, gyro),			MTDATA2_RATE_OF_TURN},
+    { XDI_DELTA_Q,		FLOAT32, 4, offsetof( MTData2_t, delta_q),		MTDATA2_DELTA_Q},
+    { XDI_MAGNETIC_FIELD,	FLOAT32, 3, offsetof( MTData2_t, mag),			MTDATA2_MAGNETIC_FIELD},
+    { XDI_STATUS_WORD,		UINT32,  1, offsetof( MTData2_t, status_word),		MTDATA2_STATUS_WORD},
+};
+
+static constexpr unsigned element_size( uint8_t format)
+{
+  return format == UINT16 ? 2 : 4;
+}
+
+static const packet_descriptor_t * find_descriptor( uint16_t data_id)
+{
+  if( data_id & XDI_PRECISION_MASK)
+    return 0; // fixed point or double
+  data_id &= ~XDI_COORDINATE_SYSTEM_MASK;
+  for( const packet_descriptor_t & descriptor : packets)
+    if( descriptor.data_id == data_id)
+      return &descriptor;
+  return 0;
+}
+
+static inline uint32_t big_endian_32( const uint8_t * p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+bool decode_MTData2( const uint8_t * message, unsigned size, MTData2_t & output)
+{
+  output.present = 0;
+
+  if( size < 4 || Xbus::getMessageId( message) != XMID_MtData2)
+    return false;
+
+  unsigned payload_length = Xbus::getPayloadLength( message);
+  unsigned header_length = Xbus::getRawLength( message) - payload_length - 1; // without checksum
+  if( header_length + payload_length > size)
+    return false;
+
+  const uint8_t * packet = message + header_length;
+  const uint8_t * end = packet + payload_length;
+
+  while( packet + 3 <= end)
+    {
+      uint16_t data_id = (packet[0] << 8) | packet[1];
+      unsigned packet_size = packet[2];
+      const uint8_t * data = packet + 3;
+      packet = data + packet_size;
+      if( packet > end)
+	return false;
+
+      const packet_descriptor_t * descriptor = find_descriptor( data_id);
+      if( descriptor == 0 || packet_size != descriptor->count * element_size( descriptor->format))
+	continue; // not configured for us
+
+      uint8_t * target = (uint8_t *)&output + descriptor->offset;
+      switch( descriptor->format)
+      {
+	case UINT16:
+	  *(uint16_t *)target = (data[0] << 8) | data[1];
+	  break;
+	case UINT32:
+	  *(uint32_t *)target = big_endian_32( data);
+	  break;
+	default: // FLOAT32
+	  for( unsigned i = 0; i < descriptor->count; ++i, data += 4)
+	    {
+	      union { uint32_t u; float f; } x;
+	      x.u = big_endian_32( data);
+	      ((float *)target)[i] = x.f;
+	    }
+	  break;
+      }
+      output.present |= descriptor->flag;
+    }
+  return true;
+}
@@ -0,0 +1,69 @@
+/** ***********************************************************************
+ * @file		MTData2_decoder.h
+ * @brief		table-driven decoder for Xsens MTData2 measurement messages
+ *
+ * An MTData2 payload is a sequence of packets: data ID (2 bytes),
+ * size (1 byte), big-endian data. The packets the firmware understands are
+ * listed in a constexpr table together with their place in MTData2_t,
+ * all others are skipped. The output configuration of the MTi can thus be
+ * changed without touching the decoder.
+ * Host check: Host_tools/MTData2_decoder_check.cpp
+ **************************************************************************/
+
+#ifndef XSENSE_MTDATA2_DECODER_H_
+#define XSENSE_MTDATA2_DECODER_H_
+
+#include "stdint.h"
+
+// XDI data IDs, coordinate system bits cleared, float32 precision
+#define XDI_PACKET_COUNTER	0x1020
+#define XDI_SAMPLE_TIME_FINE	0x1060
+#define XDI_QUATERNION		0x2010
+#define XDI_DELTA_V		0x4010
+#define XDI_ACCELERATION	0x4020
+#define XDI_RATE_OF_TURN	0x8020
+#define XDI_DELTA_Q		0x8030
+#define XDI_MAGNETIC_FIELD	0xC020
+#define XDI_STATUS_WORD		0xE020
+
+#define XDI_COORDINATE_SYSTEM_MASK	0x000C	// ENU / NED / NWU, not decoded
+#define XDI_PRECISION_MASK		0x0003	// only float32 (0) is supported
+
+//! flags in MTData2_t::present
+enum
+{
+  MTDATA2_PACKET_COUNTER	= 1 << 0,
+  MTDATA2_SAMPLE_TIME_FINE	= 1 << 1,
+  MTDATA2_QUATERNION		= 1 << 2,
+  MTDATA2_DELTA_V		= 1 << 3,
+  MTDATA2_ACCELERATION		= 1 << 4,
+  MTDATA2_RATE_OF_TURN		= 1 << 5,
+  MTDATA2_DELTA_Q		= 1 << 6,
+  MTDATA2_MAGNETIC_FIELD	= 1 << 7,
+  MTDATA2_STATUS_WORD		= 1 << 8,
+};
+
+//! decoded measurement, only fields flagged in "present" are valid
+typedef struct
+{
+  uint32_t present;
+  uint32_t sample_time_fine;	//!< 10 kHz ticks
+  uint32_t status_word;
+  uint16_t packet_counter;
+  float quaternion[4];
+  float delta_v[3];
+  float acc[3];
+  float gyro[3];
+  float delta_q[4];
+  float mag[3];
+} MTData2_t;
+
+/*! decode one MTData2 message
+ *
+ * @param message  Xbus message: preamble, bus ID, MID, length, payload
+ * @param size     number of valid bytes at message
+ * @return false if this is no MTData2 message or the message is truncated
+ */
+bool decode_MTData2( const uint8_t * message, unsigned size, MTData2_t & output);
+
+#endif /* XSENSE_MTDATA2_DECODER_H_ */
@@ -9,9 +9,14 @@
 #include "cmsis_gcc.h"
 #include "stdint.h"
 #include "communicator.h"
+#include "stage_timing.h"
+#include "MTData2_decoder.h"
+#include "IMU_decimator.h"
 
 #if RUN_MTi_1_MODULE
 
+#define IMU_SAMPLE_RATE_HZ (100 * IMU_OVERSAMPLING)
+
 // fine-tuned MTi timing parameters
 #define LONGEST_WAIT_4_MTI_MS 400
 #define PLANNED_DELAY_4_MTI_MS 20
@@ -74,11 +79,54 @@ init_ports_and_reset_mti (void) // GPIO stuff
 
 #define DATA_BUFSIZE_BYTES 128
 
-typedef union
+/*!	\brief Decode measurement, buffer layout: preamble, bus ID, MID, length, data
+	\return true if a new sample has been published
+ */
+static bool
+decode_measurement (const uint8_t *buf, unsigned size, imu_sample_t &sample,
+		    IMU_decimator *decimator)
 {
-  float f;
-  uint32_t u;
-} float_word;
+  MTData2_t data;
+  if (! decode_MTData2 (buf, size, data))
+    return false;
+
+  const uint32_t required = MTDATA2_ACCELERATION | MTDATA2_RATE_OF_TURN;
+  if ((data.present & required) != required)
+    return false;
+
+  if (data.present & MTDATA2_MAGNETIC_FIELD) // 100 Hz at most, keep the latest one
+    {
+      if (decimator)
+	decimator->feed_mag (data.mag); // delayed like acc and gyro
+      else
+	for (unsigned i = 0; i < 3; ++i)
+	  sample.mag[i] = data.mag[i];
+    }
+
+  float gyro[3];
+  for (unsigned i = 0; i < 3; ++i)
+    gyro[i] = isnormal(data.gyro[i]) ? data.gyro[i] : 0.0f;
+
+  const float *acc_out = data.acc;
+  const float *gyro_out = gyro;
+  if (decimator)
+    {
+      if (! decimator->feed (data.acc, gyro))
+	return false;
+      acc_out = decimator->acc;
+      gyro_out = decimator->gyro;
+      for (unsigned i = 0; i < 3; ++i)
+	sample.mag[i] = decimator->mag[i];
+    }
+
+  for (unsigned i = 0; i < 3; ++i)
+    {
+      sample.acc[i] = acc_out[i];
+      sample.gyro[i] = gyro_out[i];
+    }
+  imu_slot.publish( sample);
+  return true;
+}
 
 /*!	\brief Read data from the Notification and Control pipes of the device
  */
@@ -101,30 +149,6 @@ readDataFrom_MTI (MtsspInterface *device, uint8_t *buf)
   if (measurementMessageSize && measurementMessageSize < DATA_BUFSIZE_BYTES)
     {
       device->readFromPipe (&buf[2], measurementMessageSize, XBUS_MEASUREMENT_PIPE);
-      if (buf[4] == 0x40 && buf[0x13] == 0x80 && buf[0x22] == 0xC0)
-	{
-	  float_word x;
-	  x.u = __REV (*(uint32_t*) (buf + 0x07 + 0));
-	  output_data.m.acc[0] = x.f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x07 + 4));
-	  output_data.m.acc[1] = x.f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x07 + 8));
-	  output_data.m.acc[2] = x.f;
-
-	  x.u = __REV (*(uint32_t*) (buf + 0x16 + 0));
-	  output_data.m.gyro[0] = isnormal(x.f) ? x.f : 0.0f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x16 + 4));
-	  output_data.m.gyro[1] = isnormal(x.f) ? x.f : 0.0f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x16 + 8));
-	  output_data.m.gyro[2] = isnormal(x.f) ? x.f : 0.0f;
-
-	  x.u = __REV (*(uint32_t*) (buf + 0x25 + 0));
-	  output_data.m.mag[0] = x.f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x25 + 4));
-	  output_data.m.mag[1] = x.f;
-	  x.u = __REV (*(uint32_t*) (buf + 0x25 + 8));
-	  output_data.m.mag[2] = x.f;
-	}
     }
 }
 
@@ -152,7 +176,17 @@ extern "C" void EXTI15_10_IRQHandler (void)
 void HAL_GPIO_EXTI_Callback (uint16_t GPIO_Pin)
 {
   if (GPIO_Pin == IMU_DRDY)
-    MTi_ready.signal_from_ISR ();
+    {
+      timing_on_DRDY( getTime_usec_privileged());
+      if( ! mtssp_on_DRDY()) // otherwise the task is woken when the DMA chain has completed
+	MTi_ready.signal_from_ISR ();
+    }
+}
+
+//! DMA chain complete, ISR context
+static void on_measurement_frame (void)
+{
+  MTi_ready.signal_from_ISR ();
 }
 
 /*!	\brief Returns the value of the DataReady line
@@ -162,8 +196,10 @@ static inline bool checkDataReadyLine (void)
   return HAL_GPIO_ReadPin ( IMU_PORT, IMU_DRDY) == GPIO_PIN_SET;
 }
 
-static ROM uint8_t config_data[] = // config: ACC GYRO MAG STATUS
-      { 0x40, 0x20, 0x00, 0x64, 0x80, 0x20, 0x00, 0x64, 0xC0, 0x20, 0x00, 0x64, 0xE0, 0x20, 0x00, 0x00 };
+static ROM uint8_t config_data[] = // config: ACC GYRO MAG STATUS, MAG limited to 100 Hz
+      { 0x40, 0x20, IMU_SAMPLE_RATE_HZ >> 8, IMU_SAMPLE_RATE_HZ & 0xff,
+	0x80, 0x20, IMU_SAMPLE_RATE_HZ >> 8, IMU_SAMPLE_RATE_HZ & 0xff,
+	0xC0, 0x20, 0x00, 0x64, 0xE0, 0x20, 0x00, 0x00 };
 // "wrong" config:
 //{0x80,0x30,0x00,0x00,0x40,0x20,0x00,0x64,0x80,0x20,0x00,0x64,0xC0,0x20,0x00,0x64,0xE0,0x20,0x00,0x00};
 
@@ -183,13 +219,23 @@ static void run (void*)
 #if TRACE_ISR == 1
 	chn = xTraceRegisterString("MTi-ISR");
 #endif
+  bool first_start = true;
+
 restart:
 
+  if( ! first_start)
+    timing_on_IMU_restart();
+  first_start = false;
+
   acquire_privileges();
   init_ports_and_reset_mti ();
   drop_privileges();
 
   uint8_t buf[DATA_BUFSIZE_BYTES];
+  imu_sample_t sample = { 0 };
+#if IMU_OVERSAMPLING > 1
+  IMU_decimator decimator (IMU_OVERSAMPLING, 1.0f / IMU_SAMPLE_RATE_HZ);
+#endif
   MtsspDriverSpi SPI_driver;
   MtsspInterface IMU_interface (&SPI_driver);
 
@@ -256,18 +302,37 @@ restart:
       readDataFrom_MTI (&IMU_interface, buf);
     }
 
+  timing_arm_DRDY();
+
+  // from now on the SPI transfers are triggered by DRDY and chained by DMA
+  mtssp_start_measurement_DMA (on_measurement_frame);
+
   while (true)
     {
       if( false == MTi_ready.wait (DAQ_LOOP_WAIT_4_MTI_MS))
-	goto restart;
+	{
+	  mtssp_stop_measurement_DMA ();
+	  goto restart;
+	}
 
-      readDataFrom_MTI (&IMU_interface, buf);
+      uint16_t size;
+      const uint8_t *frame = mtssp_get_measurement (size);
+#if IMU_OVERSAMPLING > 1
+      if (decode_measurement (frame, size + 2, sample, &decimator))
+	sync_communicator (); // trigger computations @ 100Hz
+#else
+      decode_measurement (frame, size + 2, sample, 0);
 
       sync_communicator (); // trigger computations @ 100Hz
+#endif
     }
 }
 
+#if IMU_OVERSAMPLING > 1
+#define STACKSIZE 1024 // decimator state (about 2 kB) lives on the stack
+#else
 #define STACKSIZE 256
+#endif
 
 static uint32_t __ALIGNED(STACKSIZE*4) stack_buffer[STACKSIZE];
 
@@ -277,7 +342,7 @@ static ROM TaskParameters_t p =
   MTI_PRIORITY, stack_buffer,
     {
       { COMMON_BLOCK, COMMON_SIZE, portMPU_REGION_READ_WRITE },
-      { 0, 0, 0 },
+      { mtssp_frames, sizeof(mtssp_frames), portMPU_REGION_READ_WRITE },
       { 0, 0, 0 } } };
 
 RestrictedTask mti_driver (p);
@@ -35,12 +35,15 @@
 #include "mtssp_driver_spi.h"
 #include "stm32f4xx_hal.h"
 #include "spi.h"
+#include "xbusdef.h"
+#include "common.h"
 
 /*!	\class MtsspDriverSpi
 	\brief MtsspDriver for the SPI bus
 */
 
 #define TIMEOUT_MS 100 // dummy / unused
+#define DMA_STOP_TIMEOUT_MS 10 // a running read chain takes < 1 ms
 
 #define CHIP_SELECT_PORT	GPIOA
 #define CHIP_SELECT_PIN 	GPIO_PIN_4	// IMU_NSS
@@ -95,7 +98,124 @@ void MtsspDriverSpi::writeRaw(uint8_t const* data, int dataLength)
 	HAL_GPIO_WritePin(CHIP_SELECT_PORT, CHIP_SELECT_PIN, GPIO_PIN_SET);
 }
 
+/*	DRDY-triggered measurement read, chained from the SPI DMA completion ISR.
+	The IMU task is only woken when a complete measurement frame is available.
+*/
+
+enum mtssp_DMA_state_t { DMA_IDLE, READING_STATUS, READING_NOTIFICATION, READING_MEASUREMENT };
+
+uint8_t __ALIGNED(2 * MTSSP_FRAME_SIZE) mtssp_frames[2][MTSSP_FRAME_SIZE];
+
+static uint8_t tx_buffer[MTSSP_FRAME_SIZE]; //!< opcode + zeros
+static uint8_t status_buffer[8];
+static uint8_t notification_buffer[MTSSP_FRAME_SIZE];
+
+COMMON static volatile bool DMA_enabled;
+COMMON static volatile mtssp_DMA_state_t DMA_state;
+COMMON static void (* volatile frame_ready_callback)(void);
+COMMON static uint8_t active_frame;
+COMMON static volatile uint8_t ready_frame;
+COMMON static volatile uint16_t ready_size;
+COMMON static uint16_t measurement_size;
+COMMON uint32_t mtssp_DMA_overruns; //!< DRDY while the previous chain was still running
+
+static void start_transfer(mtssp_DMA_state_t state, uint8_t opcode, uint8_t* dest, uint16_t dataLength)
+{
+	DMA_state = state;
+	tx_buffer[0] = opcode;
+	HAL_GPIO_WritePin(CHIP_SELECT_PORT, CHIP_SELECT_PIN, GPIO_PIN_RESET);
+	if (HAL_SPI_TransmitReceive_DMA(&hspi1, tx_buffer, dest, dataLength + 4) != HAL_OK)
+	{
+		HAL_GPIO_WritePin(CHIP_SELECT_PORT, CHIP_SELECT_PIN, GPIO_PIN_SET);
+		DMA_state = DMA_IDLE;
+	}
+}
+
+static void start_measurement_transfer(void)
+{
+	if (measurement_size && measurement_size <= MTSSP_MAX_MESSAGE_SIZE)
+		start_transfer(READING_MEASUREMENT, XBUS_MEASUREMENT_PIPE, mtssp_frames[active_frame], measurement_size);
+	else
+		DMA_state = DMA_IDLE;
+}
+
+//! SPI1 DMA completion, ISR context
+static void on_transfer_complete(void)
+{
+	HAL_GPIO_WritePin(CHIP_SELECT_PORT, CHIP_SELECT_PIN, GPIO_PIN_SET);
+
+	if (!DMA_enabled)
+	{
+		DMA_state = DMA_IDLE;
+		return;
+	}
+
+	switch (DMA_state)
+	{
+	case READING_STATUS:
+	{
+		uint16_t notification_size = status_buffer[4] | (status_buffer[5] << 8);
+		measurement_size = status_buffer[6] | (status_buffer[7] << 8);
+		if (notification_size && notification_size <= MTSSP_MAX_MESSAGE_SIZE)
+			start_transfer(READING_NOTIFICATION, XBUS_NOTIFICATION_PIPE, notification_buffer, notification_size);
+		else
+			start_measurement_transfer();
+	}
+		break;
+	case READING_NOTIFICATION:
+		start_measurement_transfer();
+		break;
+	case READING_MEASUREMENT:
+	{
+		uint8_t* frame = mtssp_frames[active_frame];
+		frame[2] = XBUS_PREAMBLE; // overwrite bytes from the opcode phase
+		frame[3] = XBUS_MASTERDEVICE;
+		ready_size = measurement_size;
+		ready_frame = active_frame;
+		active_frame ^= 1;
+		DMA_state = DMA_IDLE;
+		frame_ready_callback();
+	}
+		break;
+	default:
+		DMA_state = DMA_IDLE;
+		break;
+	}
+}
+
+void mtssp_start_measurement_DMA(void (*frame_ready)(void))
+{
+	frame_ready_callback = frame_ready;
+	DMA_state = DMA_IDLE;
+	SPI_set_completion_handler(&hspi1, on_transfer_complete);
+	DMA_enabled = true;
+}
 
+void mtssp_stop_measurement_DMA(void)
+{
+	DMA_enabled = false;
+	for (unsigned i = 0; (DMA_state != DMA_IDLE) && (i < DMA_STOP_TIMEOUT_MS); ++i)
+		delay(1);
+	SPI_set_completion_handler(&hspi1, 0);
+}
 
+bool mtssp_on_DRDY(void)
+{
+	if (!DMA_enabled)
+		return false;
 
+	if (DMA_state != DMA_IDLE)
+	{
+		++mtssp_DMA_overruns;
+		return true;
+	}
 
+	start_transfer(READING_STATUS, XBUS_PIPE_STATUS, status_buffer, 4);
+	return true;
+}
+
+const uint8_t * mtssp_get_measurement(uint16_t & size)
+{
+	size = ready_size;
+	return mtssp_frames[ready_frame] + 2;
+}
@@ -46,6 +46,36 @@ class MtsspDriverSpi : public MtsspDriver
 		virtual XbusBusFormat busFormat() const { return XBF_Spi; }
 };
 
+#define MTSSP_MAX_MESSAGE_SIZE	128 // pipe contents
+#define MTSSP_FRAME_SIZE	256 // 4 bytes opcode phase + message, rounded up
+
+/*!	\brief Frame buffers of the DMA-chained measurement read.
+	Each frame: 4 bytes received during the opcode phase, then the pipe contents.
+	Size and alignment fit an MPU region for the unprivileged IMU task.
+*/
+extern uint8_t mtssp_frames[2][MTSSP_FRAME_SIZE];
+
+/*!	\brief Enable the DRDY-triggered, DMA-chained read:
+	pipe status, notification pipe (discarded), measurement pipe.
+	The complete chain runs in ISR context, frame_ready() is called from ISR.
+*/
+void mtssp_start_measurement_DMA(void (*frame_ready)(void));
+
+/*!	\brief Disable the chained read, wait until the running transaction is complete
+*/
+void mtssp_stop_measurement_DMA(void);
+
+/*!	\brief To be called from the DRDY interrupt
+	\return true if the chained read is enabled and takes care of this DRDY
+*/
+bool mtssp_on_DRDY(void);
+
+/*!	\brief Latest complete measurement frame, valid until the next-but-one frame is complete
+	\param[out] size Size of the measurement message
+	\return Buffer laid out like readDataFrom_MTI(): preamble, bus ID, MID, length, data
+*/
+const uint8_t * mtssp_get_measurement(uint16_t & size);
+
 
 
 #endif